@@ -367,6 +367,84 @@ classdef FileDecoder < matlab.mixin.Copyable
         end
     end
     
+    methods(Static)
+        function info = probe(filenames, varargin)
+            %% PROBE Read the metadata from many FLAC files at once
+            % info = FileDecoder.probe(filenames, ...)
+            % 
+            % Only the metadata blocks are read (no audio is decoded) and
+            % files are handled in parallel, so this is much faster than
+            % creating a FileDecoder for each file.
+            % INPUT:
+            % - filenames: A filename or a cell array of them
+            % PARAMETERS:
+            % - threads: Number of worker threads; 0 uses all cores (Default: 0)
+            % OUTPUT:
+            % - info: struct array (one per file) with fields filename, ok, 
+            %     message, sample_rate, channels, bits_per_sample,
+            %     total_samples (uint64; 0 if unknown), duration (sec), 
+            %     min_blocksize, max_blocksize, md5 (hex; all zeros if 
+            %     unset), has_seektable, seek_points, vendor, and comments
+            %     (cell array of 'NAME=value' strings). Files that could 
+            %     not be read have ok=false and an explanation in message.
+            % Ogg FLAC files are not supported.
+            ip = inputParser();
+            ip.addRequired('filenames', @(x) ischar(x) || iscellstr(x));
+            ip.addParameter('threads', 0, @(x) isscalar(x) && x >= 0);
+            ip.parse(filenames, varargin{:});
+            
+            check_interface('decoder_interface');
+            info = decoder_interface('probe', filenames, ip.Results.threads);
+            
+            % Tags arrive as raw UTF-8 bytes
+            for ii=1:numel(info)
+                if info(ii).ok
+                    info(ii).vendor = native2unicode(info(ii).vendor, 'UTF-8');
+                    info(ii).comments = cellfun(@(c) native2unicode(c, 'UTF-8'), ...
+                        info(ii).comments, 'UniformOutput', false);
+                end
+            end
+        end
+        
+        function report = verify(filenames, varargin)
+            %% VERIFY Check the integrity of many FLAC files at once
+            % report = FileDecoder.verify(filenames, ...)
+            %
+            % Each file is fully decoded (in parallel), checking the frame 
+            % CRCs and the MD5 signature, but the samples are discarded
+            % rather than returned to Matlab. Decoding errors are recorded
+            % and decoding continues, instead of raising an error.
+            % INPUT:
+            % - filenames: A filename or a cell array of them
+            % PARAMETERS:
+            % - threads: Number of worker threads; 0 uses all cores (Default: 0)
+            % OUTPUT:
+            % - report: struct array (one per file) with fields filename,
+            %     ok (true if everything checks out), message, md5_checked
+            %     (false if the file has no MD5 signature), md5_ok,
+            %     total_samples, samples_decoded, n_errors, error_samples
+            %     (zero-indexed sample near each error), error_types, 
+            %     seconds, samples_per_sec and bytes_per_sec.
+            % If called without an output, prints a summary instead.
+            ip = inputParser();
+            ip.addRequired('filenames', @(x) ischar(x) || iscellstr(x));
+            ip.addParameter('threads', 0, @(x) isscalar(x) && x >= 0);
+            ip.parse(filenames, varargin{:});
+            
+            check_interface('decoder_interface');
+            report = decoder_interface('verify', filenames, ip.Results.threads);
+            
+            if nargout == 0
+                bad = report(~[report.ok]);
+                fprintf('%d of %d files verified OK\n', numel(report) - numel(bad), numel(report));
+                for ii=1:numel(bad)
+                    fprintf('  %s: %s (%d errors)\n', bad(ii).filename, bad(ii).message, bad(ii).n_errors);
+                end
+                clear report
+            end
+        end
+    end
+    
     methods(Access = protected, Hidden=true)
         function cpObj = copyElement(this)
             if this.is_initialized
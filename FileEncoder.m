@@ -48,6 +48,9 @@ classdef FileEncoder < handle
         min_residual_partition_order; % Minimum partition order used for coding the residual. 
         max_residual_partition_order; % Maximum partition order used for coding the residual. 
         total_samples_estimate; % Estimated number of samples (used to avoid rewriting STREAMTABLE at end of encoding).        
+        comments;           % Vorbis comments: cell array of 'NAME=value' strings (or a struct, whose fields become NAMEs)
+        applications;       % APPLICATION blocks: struct array with fields id (4 characters) and data (uint8, char, or numeric)
+        padding;            % Size of the PADDING block, in bytes (empty for none). Padding lets update_metadata() edit tags in place.
     end
     
     properties (SetAccess=protected)
@@ -82,6 +85,8 @@ classdef FileEncoder < handle
             this.objectHandle = encoder_interface('new', varargin{:});
             this.filename = ip.Results.filename;
             this.compression_level = 5;
+            this.comments = {};
+            this.applications = struct('id', {}, 'data', {});
             
             fixed_properties = {...
                 'ogg_serial_number', 'verify', 'streamable_subset', ...
@@ -90,7 +95,8 @@ classdef FileEncoder < handle
                 'loose_mid_side_stereo', 'apodization', 'max_lpc_order', ...
                 'qlp_coeff_precision', 'qlp_coeff_prec_search', ....
                 'exhaustive_model_search', 'min_residual_partition_order', ...
-                'max_residual_partition_order', 'total_samples_estimate'};
+                'max_residual_partition_order', 'total_samples_estimate', ...
+                'comments', 'applications', 'padding'};
             for f=1:length(fixed_properties)
                 this.listener{end+1} = addlistener(this, fixed_properties{f}, 'PreSet', @FileEncoder.PreSetHandler);
             end
@@ -376,6 +382,26 @@ classdef FileEncoder < handle
         end
         
         
+        function set.comments(this, comments)
+            % These (and applications/padding) are sent to libFLAC in init()
+            this.comments = normalize_comments(comments);
+        end
+        
+        
+        function set.applications(this, apps)
+            this.applications = normalize_applications(apps);
+        end
+        
+        
+        function set.padding(this, nbytes)
+            if ~(isempty(nbytes) || (is_int(nbytes) && isscalar(nbytes) && nbytes >= 0 && nbytes < 2^24))
+                error('FileEncoder:SetPadding', 'Padding must be empty or a non-negative number of bytes less than 2^24');
+            end
+            
+            this.padding = nbytes;
+        end
+        
+        
         function ok = finish(this)
              ok = encoder_interface('finish', this.objectHandle);
              if ~ok
@@ -398,6 +424,12 @@ classdef FileEncoder < handle
                 this.filename = varargin{1};
             end
             
+             if ~isempty(this.comments) || ~isempty(this.applications) || ~isempty(this.padding)
+                 check_interface('encoder_interface');
+                 encoder_interface('set_metadata', this.objectHandle, ...
+                     this.comments, this.applications, this.padding);
+             end
+             
              encoder_interface('init', this.objectHandle, this.filename);
              this.is_initialized = true;
         end
@@ -430,11 +462,299 @@ classdef FileEncoder < handle
                  error('FileEncoder:Process', ...
                      'Unable to process submitted data. Error code %d (%s)', code, msg);
              end
-         end                   
+         end
+         
+         
+        function [best, results] = autotune(this, data, varargin)
+            %% AUTOTUNE Pick compression settings by benchmarking them on the data
+            % [best, results] = autotune(data, ...)
+            %
+            % Slices of data are encoded (in memory) and decoded again
+            % under every combination of the settings below, in parallel.
+            % The candidates on the Pareto front of compression ratio,
+            % encode rate, and decode rate are then timed again, one at a
+            % time, and the one with the best ratio that meets
+            % min_encode_rate/min_decode_rate is applied to this encoder.
+            % Call this before init() or process().
+            %
+            % If streamable_subset is set, values that the FLAC subset
+            % doesn't allow (e.g., blocksize > 4608 or max_lpc_order > 12
+            % at 48 kHz or below) are dropped with a warning.
+            %
+            % INPUT:
+            % - data: n_channels x n_samples matrix, as for process()
+            % PARAMETERS (lists of values to try; NaN or '' leaves that
+            % setting to the preset or, without a preset, as it is now):
+            % - compression_level: Default [0 2 5 8]
+            % - blocksize: Default [NaN 1024 2048 4096 4608]
+            % - apodization: Cell array of window specs. Default {''}
+            % - max_lpc_order: Default NaN
+            % - qlp_coeff_precision: Default NaN
+            % - min_residual_partition_order: Default NaN
+            % - max_residual_partition_order: Default NaN
+            % OTHER PARAMETERS:
+            % - slices: Number of slices taken from data. Default: 8
+            % - slice_length: Samples per slice. Default: 65536
+            % - min_encode_rate: Minimum encode speed (samples/sec). Default 0
+            % - min_decode_rate: Minimum decode speed (samples/sec). Default 0
+            % - threads: Worker threads; 0 uses all cores. Default 0
+            % - apply: If true, apply the chosen settings. Default true
+            % OUTPUT:
+            % - best: Chosen candidate from results (empty if none qualify)
+            % - results: struct array with the settings for each candidate,
+            %     plus ok, bytes, compression_ratio, encode_rate, 
+            %     decode_rate (samples/sec, per channel) and pareto.
+            %
+            % For candidates off the Pareto front, rates are measured while
+            % other candidates are running on the remaining cores, so treat
+            % them as relative, not absolute.
+            
+            ip = inputParser();
+            ip.addRequired('data', @(x) isnumeric(x) && ismatrix(x));
+            ip.addParameter('compression_level', [0 2 5 8], @isnumeric);
+            ip.addParameter('blocksize', [NaN 1024 2048 4096 4608], @isnumeric);
+            ip.addParameter('apodization', {''}, @(x) iscell(x) || ischar(x));
+            ip.addParameter('max_lpc_order', NaN, @isnumeric);
+            ip.addParameter('qlp_coeff_precision', NaN, @isnumeric);
+            ip.addParameter('min_residual_partition_order', NaN, @isnumeric);
+            ip.addParameter('max_residual_partition_order', NaN, @isnumeric);
+            ip.addParameter('slices', 8, @(x) is_int(x) && x > 0);
+            ip.addParameter('slice_length', 65536, @(x) is_int(x) && x > 0);
+            ip.addParameter('min_encode_rate', 0, @isnumeric);
+            ip.addParameter('min_decode_rate', 0, @isnumeric);
+            ip.addParameter('threads', 0, @(x) is_int(x) && x >= 0);
+            ip.addParameter('apply', true, @is_logicalish);
+            ip.parse(data, varargin{:});
+            
+            if this.is_initialized
+                error('FileEncoder:AlreadyInitalized', 'Cannot autotune because the encoder has already been initalized');
+            end
+            
+            n_ch = this.channels;
+            if size(data, 1) ~= n_ch
+                error('FileEncoder:InputDataShape', ...
+                    'Data submitted for autotuning in the wrong shape: Should be %d (channels) x nsamples)', n_ch);
+            end
+            
+            % Evenly spaced slices across the data
+            n = size(data, 2);
+            len = min(ip.Results.slice_length, n);
+            starts = unique(round(linspace(1, n - len + 1, ip.Results.slices)));
+            slices = arrayfun(@(s) int32(data(:, s:(s+len-1))), starts, 'UniformOutput', false);
+            
+            % Every combination of the settings
+            names = {'compression_level', 'blocksize', 'apodization', ...
+                'max_lpc_order', 'qlp_coeff_precision', ...
+                'min_residual_partition_order', 'max_residual_partition_order'};
+            values = cell(size(names));
+            for ii=1:length(names)
+                v = ip.Results.(names{ii});
+                if strcmp(names{ii}, 'apodization')
+                    if ischar(v)
+                        v = {v};
+                    end
+                    v = cellfun(@FileEncoder.join_windows, v, 'UniformOutput', false);
+                else
+                    v = num2cell(v);
+                end
+                values{ii} = v;
+            end
+            
+            % libFLAC refuses to initialize with settings outside the
+            % subset, so don't bother trying them
+            if this.streamable_subset
+                if this.sample_rate <= 48000
+                    limits = struct('blocksize', 4608, 'max_lpc_order', 12, 'max_residual_partition_order', 8);
+                else
+                    limits = struct('blocksize', 16384, 'max_residual_partition_order', 8);
+                end
+                limited = fieldnames(limits);
+                for ii=1:length(limited)
+                    k = strcmp(names, limited{ii});
+                    v = values{k};
+                    drop = cellfun(@(x) x > limits.(limited{ii}), v);
+                    if any(drop)
+                        warning('FileEncoder:AutotuneNotStreamable', ...
+                            'Skipping %s > %d, which is outside the streamable subset at %d samples/sec', ...
+                            limited{ii}, limits.(limited{ii}), this.sample_rate);
+                        values{k} = v(~drop);
+                    end
+                end
+                if any(cellfun(@isempty, values))
+                    error('FileEncoder:AutotuneNotStreamable', ...
+                        'No candidates are within the streamable subset; set streamable_subset = false to try them anyway');
+                end
+            end
+            
+            ranges = cellfun(@(v) 1:length(v), values, 'UniformOutput', false);
+            idx = cell(size(names));
+            [idx{:}] = ndgrid(ranges{:});
+            
+            candidates = struct();
+            for c=1:numel(idx{1})
+                for ii=1:length(names)
+                    candidates(c).(names{ii}) = values{ii}{idx{ii}(c)};
+                end
+            end
+            
+            current_windows = FileEncoder.join_windows(this.apodization);
+            check_interface('encoder_interface');
+            measured = encoder_interface('autotune', this.objectHandle, ...
+                slices, candidates, current_windows, ip.Results.threads);
+            
+            % Merge the settings and measurements back together
+            results = candidates;
+            fields = fieldnames(measured);
+            for c=1:numel(results)
+                for ii=1:length(fields)
+                    results(c).(fields{ii}) = measured(c).(fields{ii});
+                end
+            end
+            
+            % Pareto front: candidates that no other candidate beats on
+            % every measure at once
+            pareto = FileEncoder.pareto_front(results, [results.ok]);
+            
+            % Rates measured under contention can be far below what one
+            % encoder gets on its own, so time the front again serially
+            % before comparing against the absolute thresholds
+            front = find(pareto);
+            if ~isempty(front)
+                serial = encoder_interface('autotune', this.objectHandle, ...
+                    slices, candidates(front), current_windows, 1);
+                for ii=1:numel(front)
+                    results(front(ii)).encode_rate = serial(ii).encode_rate;
+                    results(front(ii)).decode_rate = serial(ii).decode_rate;
+                end
+                pareto(front) = [serial.ok];
+                pareto = FileEncoder.pareto_front(results, pareto);
+            end
+            for c=1:numel(results)
+                results(c).pareto = pareto(c);
+            end
+            
+            eligible = find([results.pareto] & ...
+                [results.encode_rate] >= ip.Results.min_encode_rate & ...
+                [results.decode_rate] >= ip.Results.min_decode_rate);
+            if isempty(eligible)
+                best = [];
+                warning('FileEncoder:AutotuneNoCandidate', 'No candidate met the requested encode/decode rates; settings unchanged');
+            else
+                [~, b] = max([results(eligible).compression_ratio]);
+                best = results(eligible(b));
+                if ip.Results.apply
+                    this.apply_tuning(best);
+                end
+            end
+            
+            if nargout == 0
+                front = results([results.pareto]);
+                fprintf('%6s %9s %10s %8s %14s %14s  %s\n', 'level', 'blocksize', 'max_lpc', 'ratio', 'encode (S/s)', 'decode (S/s)', 'apodization');
+                for c=1:numel(front)
+                    fprintf('%6g %9g %10g %8.3f %14.4g %14.4g  %s\n', front(c).compression_level, ...
+                        front(c).blocksize, front(c).max_lpc_order, front(c).compression_ratio, ...
+                        front(c).encode_rate, front(c).decode_rate, front(c).apodization);
+                end
+            end
+        end
+    end
+    
+    
+    methods(Access = protected)
+        function apply_tuning(this, config)
+            %% APPLY_TUNING Apply a candidate from autotune() to this encoder
+            % The compression level goes first, since it resets the others.
+            if ~isnan(config.compression_level)
+                this.compression_level = config.compression_level;
+            end
+            
+            if ~isnan(config.blocksize)
+                this.blocksize = config.blocksize;
+            end
+            
+            if ~isempty(config.apodization)
+                this.apodization = config.apodization;
+            end
+            
+            fields = {'max_lpc_order', 'qlp_coeff_precision', ...
+                'min_residual_partition_order', 'max_residual_partition_order'};
+            for ii=1:length(fields)
+                if ~isnan(config.(fields{ii}))
+                    this.(fields{ii}) = config.(fields{ii});
+                end
+            end
+        end
+    end
+    
+    
+    methods(Static, Access = protected)
+        function pareto = pareto_front(results, ok)
+            %% PARETO_FRONT Find the candidates (among ok) that no other candidate beats on every measure
+            scores = [[results.compression_ratio]' [results.encode_rate]' [results.decode_rate]'];
+            pareto = false(1, numel(results));
+            for c=1:numel(results)
+                if ok(c)
+                    at_least = all(bsxfun(@ge, scores, scores(c,:)), 2);
+                    better = any(bsxfun(@gt, scores, scores(c,:)), 2);
+                    pareto(c) = ~any(ok(:) & at_least & better);
+                end
+            end
+        end
+        
+        function winstr = join_windows(windows)
+            %% JOIN_WINDOWS Validate apodization windows and join them with semicolons
+            if isempty(windows)
+                winstr = '';
+                return;
+            elseif ischar(windows)
+                windows = strsplit(windows, ';');
+            end
+            
+            for ii=1:length(windows)
+                [ok, msg] = FileEncoder.check_window(windows{ii});
+                if ~ok
+                    error('FileEncoder:BadWindow', msg);
+                end
+            end
+            winstr = strjoin(windows, ';');
+        end
     end
     
     
     methods(Static)
+        function rewritten = update_metadata(filename, varargin)
+            %% UPDATE_METADATA Edit the comments/applications of an existing FLAC file
+            % rewritten = FileEncoder.update_metadata(filename, ...)
+            %
+            % The new metadata is written into the file's existing padding,
+            % so the audio is neither re-encoded nor copied and the cost
+            % does not depend on the file's size. Set the padding property
+            % when encoding to leave room for this.
+            % PARAMETERS:
+            % - comments: 'NAME=value' strings (or a struct). These replace
+            %     existing comments with the same NAME; others are kept.
+            % - applications: struct array with fields id and data. These
+            %     replace existing APPLICATION blocks with the same id.
+            % - allow_rewrite: If the new metadata does not fit in the
+            %     padding, rewrite the whole file (true) or raise an error
+            %     (false). Default: false
+            % OUTPUT:
+            % - rewritten: True if the whole file had to be rewritten
+            ip = inputParser();
+            ip.addRequired('filename', @ischar);
+            ip.addParameter('comments', {});
+            ip.addParameter('applications', struct('id', {}, 'data', {}));
+            ip.addParameter('allow_rewrite', false, @is_logicalish);
+            ip.parse(filename, varargin{:});
+            
+            check_interface('encoder_interface');
+            rewritten = encoder_interface('update_metadata', filename, ...
+                normalize_comments(ip.Results.comments), ...
+                normalize_applications(ip.Results.applications), ...
+                logical(ip.Results.allow_rewrite));
+        end
+        
+        
         function [windows, parameterized_windows] = get_apodization_windows()
             %% GET_APODIZATION_WINDOWS Return a list of possible apodization windows
             % [windows, parameterized_windows] = get_apodization_windows()
@@ -579,4 +899,56 @@ function bool_p = is_logicalish(x)
 bool_p = islogical(x) || (x == 0 || x == 1);
 end
 
-    
\ No newline at end of file
+function comments = normalize_comments(comments)
+%% NORMALIZE_COMMENTS: Convert comments to a cell array of 'NAME=value' strings
+if isempty(comments)
+    comments = {};
+elseif ischar(comments)
+    comments = {comments};
+elseif isstruct(comments) && isscalar(comments)
+    names = fieldnames(comments);
+    values = struct2cell(comments);
+    for ii=1:length(values)
+        if isnumeric(values{ii}) || islogical(values{ii})
+            values{ii} = num2str(values{ii});
+        end
+    end
+    comments = strcat(names, '=', values)';
+elseif ~iscellstr(comments)
+    error('FileEncoder:BadComment', 'Comments must be a cell array of ''NAME=value'' strings or a struct');
+end
+
+for ii=1:length(comments)
+    if ~any(comments{ii} == '=')
+        error('FileEncoder:BadComment', 'Comment ''%s'' is not of the form NAME=value', comments{ii});
+    end
+end
+end
+
+function apps = normalize_applications(apps)
+%% NORMALIZE_APPLICATIONS: Check APPLICATION blocks and convert their data to uint8
+if isempty(apps)
+    apps = struct('id', {}, 'data', {});
+    return;
+elseif ~isstruct(apps) || ~all(isfield(apps, {'id', 'data'}))
+    error('FileEncoder:BadApplication', 'Applications must be a struct array with fields id and data');
+end
+
+for ii=1:numel(apps)
+    if ~ischar(apps(ii).id) || length(apps(ii).id) ~= 4
+        error('FileEncoder:BadApplication', 'Application ids must be four characters long');
+    end
+    
+    data = apps(ii).data;
+    if ischar(data)
+        data = unicode2native(data, 'UTF-8');
+    elseif islogical(data)
+        data = uint8(data);
+    elseif ~isa(data, 'uint8')
+        data = typecast(data(:)', 'uint8'); % Raw bytes, in native byte order
+    end
+    apps(ii).data = data(:)';
+end
+end
+
+    
\ No newline at end of file
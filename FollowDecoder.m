@@ -0,0 +1,145 @@
+classdef FollowDecoder < handle
+    %% FollowDecoder Decode a FLAC file while it is still being written
+    %
+    % This is meant for live displays of a recording that another process
+    % (e.g., a FileEncoder) is still writing. Open the file once and then
+    % repeatedly ask for whatever has been added since the last call:
+    %    follower = FollowDecoder('live.flac', 'lookback', 5);
+    %    while true
+    %        [data, start] = follower.next_chunk(0.1);
+    %        % ...plot data, which begins at sample start...
+    %    end
+    %
+    % When the decoder reaches the current end of the file, it waits (up
+    % to the timeout) for the file to grow. Frames that are only partly
+    % written are decoded on a later call, once they are complete.
+    %
+    % Note that total_samples is not available: libFLAC only writes it to
+    % STREAMINFO when the encoder finishes.
+
+    properties (SetAccess = private)
+        filename        % File being followed
+        lookback        % Seconds before the end of the file where decoding started (Inf = start of file)
+    end
+
+    properties (Dependent)
+        ready           % True once the file's metadata has been read
+        channels        % Number of channels (once ready)
+        sample_rate     % Sample rate, in samples/sec (once ready)
+        bits_per_sample % Bits per sample (once ready)
+        position        % Next sample to be decoded (zero-indexed, as in FileDecoder.seek_absolute)
+        n_errors        % Number of decoding errors (e.g., bad frames skipped)
+    end
+
+    properties (Hidden = true, GetAccess = private)
+        objectHandle
+    end
+
+
+    methods
+        function this = FollowDecoder(filename, varargin)
+            %% Start following a FLAC file
+            % INPUT:
+            % - filename: FLAC file (which may still be growing)
+            % OPTIONAL PARAMETERS:
+            % - lookback: Start decoding about this many seconds before the
+            %      current end of the file, instead of at the beginning.
+            %      (The position is estimated from the compression ratio
+            %      so far, so it won't be exact.)
+            %      (Default: Inf, i.e., decode everything)
+            ip = inputParser();
+            ip.addRequired('filename', @ischar);
+            ip.addParameter('lookback', Inf, @(x) isscalar(x) && x >= 0);
+            ip.parse(filename, varargin{:});
+
+            this.filename = ip.Results.filename;
+            this.lookback = ip.Results.lookback;
+
+            check_interface('decoder_interface');
+            if isinf(this.lookback)
+                this.objectHandle = decoder_interface('follow_new', this.filename, -1);
+            else
+                this.objectHandle = decoder_interface('follow_new', this.filename, this.lookback);
+            end
+        end
+
+        function delete(this)
+            %% DELETE Close the file
+            if ~isempty(this.objectHandle)
+                decoder_interface('follow_delete', this.objectHandle);
+            end
+        end
+
+        function [data, start] = next_chunk(this, timeout, varargin)
+            %% NEXT_CHUNK Decode the data written since the last call
+            % [data, start] = next_chunk(timeout, ...)
+            % INPUT:
+            % - timeout: Maximum time (in seconds) to wait for new data.
+            %      Returns immediately once some data has been decoded and
+            %      the decoder has caught up with the end of the file.
+            %      (Default: 0.05)
+            % PARAMETERS:
+            % - max_samples: Stop after (at least) this many samples, even
+            %      if more are available. (Default: Inf)
+            % - asDouble: If true, return data as a double. Default: true
+            % OUTPUT:
+            % - data: [nChannels x nSamples] matrix; empty if nothing new
+            %      arrived before the timeout
+            % - start: Sample number (1-indexed) of the first column of data
+            % Data is always contiguous. If frames had to be skipped (e.g.,
+            % a CRC mismatch), data stops before the gap and the next call 
+            % picks up after it, so start jumps ahead.
+            if nargin < 2 || isempty(timeout)
+                timeout = 0.05;
+            end
+
+            ip = inputParser();
+            ip.addRequired('timeout', @(x) isscalar(x) && x >= 0);
+            ip.addParameter('max_samples', Inf, @(x) isscalar(x) && x > 0);
+            ip.addParameter('asDouble', true, @islogical);
+            ip.parse(timeout, varargin{:});
+
+            max_samples = ip.Results.max_samples;
+            if isinf(max_samples)
+                max_samples = 0; % No limit
+            end
+
+            [data, start] = decoder_interface('follow_next_chunk', this.objectHandle, timeout, max_samples);
+            start = double(start) + 1;
+            if ip.Results.asDouble
+                data = double(data);
+            end
+        end
+
+        %% Getters
+        function tf = get.ready(this)
+            tf = this.get_info().ready;
+        end
+
+        function n_channels = get.channels(this)
+            n_channels = this.get_info().channels;
+        end
+
+        function fs = get.sample_rate(this)
+            fs = this.get_info().sample_rate;
+        end
+
+        function bps = get.bits_per_sample(this)
+            bps = this.get_info().bits_per_sample;
+        end
+
+        function pos = get.position(this)
+            pos = this.get_info().position;
+        end
+
+        function n = get.n_errors(this)
+            n = this.get_info().n_errors;
+        end
+    end
+
+    methods (Access = private)
+        function info = get_info(this)
+            info = decoder_interface('follow_get_info', this.objectHandle);
+        end
+    end
+end
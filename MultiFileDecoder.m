@@ -0,0 +1,127 @@
+classdef MultiFileDecoder < handle
+    %% MultiFileDecoder Decode a series of FLAC files as if they were one
+    %
+    % Recordings that are split across several files (e.g., rolled over
+    % every hour) can be read as a single, continuous stream:
+    %    decoder = MultiFileDecoder({'hour01.flac', 'hour02.flac', 'hour03.flac'});
+    %    data = decoder.read_segment(start, stop);
+    % Sample numbers refer to the combined stream, and reads that cross a
+    % file boundary are stitched together internally.
+    %
+    % The files must have the same number of channels, sample rate, and
+    % bits per sample, and their STREAMINFO must record their length. A
+    % few files are kept open at once (see cache_size), so moving back and
+    % forth across a boundary doesn't require reopening the files.
+    %
+    % Like FileDecoder, instances of this class are not thread-safe.
+
+    properties (SetAccess = private)
+        filenames       % Files, in order
+        file_starts     % First sample (1-indexed, as in read_segment) of each file
+        total_samples   % Total number of samples per channel, across all files
+        channels        % Number of channels
+        sample_rate     % Sample rate (in samples/sec)
+        bits_per_sample % Bits per sample
+        cache_size      % Maximum number of files kept open at once
+    end
+
+    properties (Dependent)
+        position        % Next sample to be read (zero-indexed, as in seek_absolute)
+    end
+
+    properties (Hidden = true, GetAccess = private)
+        objectHandle
+    end
+
+
+    methods
+        function this = MultiFileDecoder(filenames, varargin)
+            %% Open a series of FLAC files
+            % INPUT:
+            % - filenames: Cell array of filenames, in order
+            % OPTIONAL PARAMETERS:
+            % - cache_size: Number of files to keep open (Default: 4)
+            % - threads: Threads used to check the files when opening
+            %      them; 0 uses all cores (Default: 0)
+            ip = inputParser();
+            ip.addRequired('filenames', @(x) ischar(x) || iscellstr(x));
+            ip.addParameter('cache_size', 4, @(x) isscalar(x) && x >= 1);
+            ip.addParameter('threads', 0, @(x) isscalar(x) && x >= 0);
+            ip.parse(filenames, varargin{:});
+
+            check_interface('decoder_interface');
+            this.objectHandle = decoder_interface('concat_new', ip.Results.filenames, ...
+                ip.Results.cache_size, ip.Results.threads);
+
+            info = decoder_interface('concat_get_info', this.objectHandle);
+            this.filenames = info.filenames;
+            this.file_starts = info.starts + 1;
+            this.total_samples = info.total_samples;
+            this.channels = info.channels;
+            this.sample_rate = info.sample_rate;
+            this.bits_per_sample = info.bits_per_sample;
+            this.cache_size = info.cache_size;
+        end
+
+        function delete(this)
+            %% DELETE Close all the files
+            if ~isempty(this.objectHandle)
+                decoder_interface('concat_delete', this.objectHandle);
+            end
+        end
+
+        function pos = get.position(this)
+            info = decoder_interface('concat_get_info', this.objectHandle);
+            pos = info.position;
+        end
+
+        function [file_index, offset] = locate(this, sample)
+            %% LOCATE Find the file holding a sample
+            % INPUT:
+            % - sample: Sample number (1-indexed, as in read_segment)
+            % OUTPUT:
+            % - file_index: Index into filenames
+            % - offset: Sample number (1-indexed) within that file
+            if sample < 1 || sample > this.total_samples
+                error('MultiFileDecoder:OutOfRange', 'Sample %d is outside the recording', sample);
+            end
+            file_index = find(this.file_starts <= sample, 1, 'last');
+            offset = sample - this.file_starts(file_index) + 1;
+        end
+
+        function ok = seek_absolute(this, pos)
+            %% SEEK_ABSOLUTE Seek to an absolute position within the recording
+            % INPUT:
+            % - pos: Position in samples (zero-indexed, like FileDecoder)
+            % OUTPUT:
+            % - ok: True if seek is sucessful, false otherwise.
+            ok = decoder_interface('concat_seek_absolute', this.objectHandle, pos);
+        end
+
+        function data = read_segment(this, start, stop, varargin)
+            %% READ_SEGMENT Read a segment from the recording and return it
+            % INPUT:
+            % - start: first sample to extract
+            % - stop:  last sample to extract
+            % PARAMETERS:
+            % - asDouble: If true, return data as a double. Default: true
+            % OUTPUT:
+            % - data as an [nChannels x nSamples] matrix
+            ip = inputParser();
+            ip.addRequired('start', @(x) x>0);
+            ip.addRequired('stop', @(x) x>0);
+            ip.addParameter('asDouble', true, @islogical);
+            ip.parse(start, stop, varargin{:});
+
+            if stop < start || stop > this.total_samples
+                error('MultiFileDecoder:OutOfRange', ...
+                    'Cannot read samples %d-%d from a recording with %d samples', start, stop, this.total_samples);
+            end
+
+            data = decoder_interface('concat_read', this.objectHandle, start - 1, stop - start + 1);
+            if ip.Results.asDouble
+                data = double(data);
+            end
+        end
+    end
+end
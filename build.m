@@ -10,6 +10,12 @@ files= {
     'decoder_interface.cpp'
     };
 
+% The batch commands (autotune, etc) use std::thread
+extra_flags = {};
+if isunix
+    extra_flags = {'-lpthread'};
+end
+
 for f=1:length(files)
     try
     mex('-v', ...
@@ -17,6 +23,7 @@ for f=1:length(files)
         sprintf('-L%s', fullfile(FLAC_PATH, 'lib', '')), ...
         '-lFLAC', ...
         '-lFLAC++', ...
+        extra_flags{:}, ...
         files{f});
     catch E
         disp(E.message);
@@ -1,11 +1,22 @@
 #include "mex.h"
 #include "matrix.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <list>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "class_handle.hpp"
+#include "parallel_for.hpp"
 
 #include <FLAC++/decoder.h>
+#include <FLAC++/metadata.h>
+
+// Same version as encoder_interface.cpp; bump both together
+static const int INTERFACE_VERSION = 2;
 
 class BufferDecoder;
 
@@ -18,6 +29,27 @@ void is_valid(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[], Buffer
 
 void buffer_ops(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[], const char* cmd, BufferDecoder* decoder);
 
+void probe(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[]);
+void verify(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[]);
+std::vector<std::string> get_filenames(const mxArray* arg);
+
+class ConcatDecoder;
+void concat_ops(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[], const char* cmd);
+
+class FollowDecoder;
+void follow_ops(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[], const char* cmd);
+
+// 64-bit file offsets, since recordings can easily pass 2 GB
+#ifdef _WIN32
+#define FOLLOW_FSEEK _fseeki64
+#define FOLLOW_FTELL _ftelli64
+typedef __int64 follow_off_t;
+#else
+#define FOLLOW_FSEEK fseeko
+#define FOLLOW_FTELL ftello
+typedef off_t follow_off_t;
+#endif
+
 
 class BufferDecoder: public FLAC::Decoder::File { 
     /* This class extends the FLAC::Decoder::File decoder so that it writes
@@ -35,6 +67,14 @@ public:
         buffer.reserve(new_size);
     }
     
+    size_t length(void) const {
+        return buffer.size();
+    }
+    
+    const FLAC__uint32* data(void) const {
+        return buffer.data();
+    }
+    
     mxArray* to_mxArray(void) {
         /* Copy the buffer to an mxArray, which we then export to matlab.
          * I debated making this just export buffer.data() to avoid the copy
@@ -83,6 +123,448 @@ protected:
 
 
 
+class VerifyDecoder: public FLAC::Decoder::File {
+    /* Decodes a whole file but throws the samples away, recording errors
+     * instead of raising them. This is what verify runs on its worker 
+     * threads, so (unlike BufferDecoder) it must never call into MATLAB.
+     */
+public:
+    VerifyDecoder() : FLAC::Decoder::File(), n_samples(0), next_sample(0), 
+        total_samples(0), has_md5(false) { }
+    
+    FLAC__uint64 n_samples;     // Samples decoded so far
+    FLAC__uint64 next_sample;   // First sample after the last good frame
+    FLAC__uint64 total_samples; // According to STREAMINFO (0 if unknown)
+    bool has_md5;               // False if the encoder didn't store an MD5
+    std::vector<FLAC__uint64> error_samples;
+    std::vector<FLAC__StreamDecoderErrorStatus> error_codes;
+    
+protected:
+    FLAC__StreamDecoderWriteStatus write_callback(const ::FLAC__Frame *frame, const FLAC__int32 * const []) {
+        n_samples += frame->header.blocksize;
+        next_sample = frame->header.number.sample_number + frame->header.blocksize;
+        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+    }
+    
+    void metadata_callback(const ::FLAC__StreamMetadata *metadata) {
+        if(metadata->type == FLAC__METADATA_TYPE_STREAMINFO) {
+            total_samples = metadata->data.stream_info.total_samples;
+            for(int b = 0; b < 16; b++)
+                has_md5 = has_md5 || (metadata->data.stream_info.md5sum[b] != 0);
+        }
+    }
+    
+    void error_callback(FLAC__StreamDecoderErrorStatus status) {
+        // libFLAC resyncs on its own; we just note where it happened
+        error_samples.push_back(next_sample);
+        error_codes.push_back(status);
+    }
+};
+
+
+
+class ConcatDecoder {
+    /* Presents an ordered list of files (with matching STREAMINFO) as one
+     * continuous stream. A few BufferDecoders are kept open, and the least
+     * recently used one is closed when another is needed, so reads that 
+     * straddle a file boundary don't pay to reopen the files each time.
+     */
+public:
+    ConcatDecoder(const std::vector<std::string>& filenames, const std::vector<FLAC__uint64>& lengths, 
+            unsigned channels, unsigned sample_rate, unsigned bits_per_sample, size_t cache_size) :
+        filenames(filenames), channels(channels), sample_rate(sample_rate), 
+        bits_per_sample(bits_per_sample), cache_size(std::max<size_t>(cache_size, 1)), position(0) {
+        starts.push_back(0);
+        for(size_t f = 0; f < lengths.size(); f++)
+            starts.push_back(starts.back() + lengths[f]);
+    }
+    
+    ~ConcatDecoder() {
+        for(auto& entry : open_decoders) {
+            entry.second->finish();
+            delete entry.second;
+        }
+    }
+    
+    FLAC__uint64 get_total_samples(void) const {
+        return starts.back();
+    }
+    
+    size_t find_file(FLAC__uint64 sample) const {
+        /* Index of the file holding (zero-indexed) global sample */
+        return std::upper_bound(starts.begin(), starts.end(), sample) - starts.begin() - 1;
+    }
+    
+    bool seek_absolute(FLAC__uint64 sample) {
+        if(sample >= get_total_samples())
+            return false;
+        
+        size_t f = find_file(sample);
+        BufferDecoder* decoder = get_decoder(f);
+        decoder->clear();
+        if(!decoder->seek_absolute(sample - starts[f])) {
+            close_decoder(f); // Otherwise it's stuck in SEEK_ERROR
+            return false;
+        }
+        position = sample;
+        return true;
+    }
+    
+    bool read(FLAC__uint64 start, FLAC__uint64 n_samples, FLAC__int32* dst) {
+        /* Decode n_samples (per channel) beginning at global sample start 
+         * into dst, which must hold n_samples * channels values.
+         */
+        if(start + n_samples > get_total_samples())
+            return false;
+        
+        while(n_samples > 0) {
+            size_t f = find_file(start);
+            FLAC__uint64 count = std::min(n_samples, starts[f+1] - start);
+            size_t n_values = static_cast<size_t>(count * channels);
+            
+            // Seeking leaves the frame holding the target sample in the buffer
+            BufferDecoder* decoder = get_decoder(f);
+            decoder->clear();
+            decoder->preallocate(n_values);
+            if(!decoder->seek_absolute(start - starts[f])) {
+                close_decoder(f);
+                return false;
+            }
+            
+            while(decoder->length() < n_values) {
+                if(!decoder->process_single() || 
+                        decoder->get_state() == FLAC__STREAM_DECODER_END_OF_STREAM)
+                    break;
+            }
+            if(decoder->length() < n_values)
+                return false;
+            
+            memcpy(dst, decoder->data(), n_values * sizeof(FLAC__int32));
+            decoder->clear();
+            
+            dst += n_values;
+            start += count;
+            n_samples -= count;
+        }
+        
+        position = start;
+        return true;
+    }
+    
+    const std::vector<std::string> filenames;
+    std::vector<FLAC__uint64> starts; // First global sample of each file, then the total
+    const unsigned channels;
+    const unsigned sample_rate;
+    const unsigned bits_per_sample;
+    const size_t cache_size;
+    FLAC__uint64 position;            // Next sample to be read
+    
+protected:
+    std::list<std::pair<size_t, BufferDecoder*> > open_decoders; // Most recently used first
+    
+    BufferDecoder* get_decoder(size_t f) {
+        for(auto it = open_decoders.begin(); it != open_decoders.end(); ++it) {
+            if(it->first == f) {
+                open_decoders.splice(open_decoders.begin(), open_decoders, it);
+                return it->second;
+            }
+        }
+        
+        if(open_decoders.size() >= cache_size) {
+            BufferDecoder* oldest = open_decoders.back().second;
+            oldest->finish();
+            delete oldest;
+            open_decoders.pop_back();
+        }
+        
+        BufferDecoder* decoder = new BufferDecoder;
+        open_decoders.push_front(std::make_pair(f, decoder));
+        if(decoder->init(filenames[f].c_str()) != FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+            close_decoder(f);
+            mexErrMsgIdAndTxt("FileDecoder:FileError", "Unable to open file %s", filenames[f].c_str());
+        }
+        return decoder;
+    }
+    
+    void close_decoder(size_t f) {
+        for(auto it = open_decoders.begin(); it != open_decoders.end(); ++it) {
+            if(it->first == f) {
+                it->second->finish();
+                delete it->second;
+                open_decoders.erase(it);
+                return;
+            }
+        }
+    }
+};
+
+
+
+class FollowDecoder: public FLAC::Decoder::Stream {
+    /* Decodes a file that is still being written. When the decoder runs
+     * into the current end of the file, the read callback polls for the 
+     * file to grow (until a deadline) instead of ending the stream.
+     *
+     * If the deadline passes partway through a frame, the decoder is
+     * flushed and the file rewound to the end of the last complete frame,
+     * so the partial frame is decoded again once the rest of it arrives.
+     * Polling is used instead of inotify, which isn't portable and doesn't
+     * see writes made over network filesystems.
+     */
+public:
+    FollowDecoder(FILE* fp, double lookback) : FLAC::Decoder::Stream(), 
+        channels(0), sample_rate(0), bits_per_sample(0), first_sample(0), next_sample(0),
+        frame_end(0), n_errors(0), metadata_done(false),
+        fp(fp), lookback(lookback), skip_frame(false), bad_sample(0), 
+        pending_first(0), gap(false), measuring(false), measured(false),
+        measured_sample(0), measured_end(0), resyncing(false) { }
+    
+    ~FollowDecoder() {
+        finish();
+        fclose(fp);
+    }
+    
+    void next_chunk(double timeout, size_t max_samples) {
+        /* Decode whatever complete frames are available, waiting up to 
+         * timeout seconds for the first one. Returns as soon as it has 
+         * some data and reaches the (current) end of the file, or has at 
+         * least max_samples (0 = no limit). The output is always 
+         * contiguous: if frames were skipped, the chunk stops at the gap 
+         * and the next one starts after it.
+         */
+        buffer.clear();
+        deadline = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(timeout));
+        
+        // Frames from after a gap last time
+        if(!pending.empty()) {
+            buffer.swap(pending);
+            first_sample = pending_first;
+            deadline = clock::now();
+        }
+        gap = false;
+        
+        if(!metadata_done) {
+            if(!process_until_end_of_metadata() || get_state() == FLAC__STREAM_DECODER_ABORTED) {
+                // Not all of the metadata has been written yet; start over next time
+                reset();
+                FOLLOW_FSEEK(fp, 0, SEEK_SET);
+                return;
+            }
+            metadata_done = true;
+            start_from_lookback();
+        }
+        
+        while(max_samples == 0 || buffer.size() < max_samples * channels) {
+            bool ok = process_single();
+            FLAC__StreamDecoderState state = get_state();
+            if(state == FLAC__STREAM_DECODER_ABORTED) {
+                // Ran out of time (maybe mid-frame): back up to the last whole frame
+                flush();
+                FOLLOW_FSEEK(fp, static_cast<follow_off_t>(frame_end), SEEK_SET);
+                break;
+            }
+            if(!ok || gap || state == FLAC__STREAM_DECODER_END_OF_STREAM)
+                break;
+        }
+    }
+    
+    FLAC__uint64 position(void) const {
+        // Next sample the caller will see
+        return pending.empty() ? next_sample : pending_first;
+    }
+    
+    mxArray* to_mxArray(void) const {
+        mxArray* array = mxCreateNumericMatrix(channels, 0, mxINT32_CLASS, mxREAL);
+        if(channels > 0 && !buffer.empty()) {
+            mxDestroyArray(array);
+            array = mxCreateUninitNumericMatrix(channels, buffer.size() / channels, mxINT32_CLASS, mxREAL);
+            memcpy(mxGetData(array), buffer.data(), buffer.size() * sizeof(buffer[0]));
+        }
+        return array;
+    }
+    
+    // From STREAMINFO
+    unsigned channels;
+    unsigned sample_rate;
+    unsigned bits_per_sample;
+    
+    std::vector<FLAC__int32> buffer; // Interleaved samples from the last next_chunk()
+    FLAC__uint64 first_sample;       // Sample number of the start of buffer
+    FLAC__uint64 next_sample;        // Sample after the last complete frame
+    FLAC__uint64 frame_end;          // Byte offset just past the last complete frame
+    unsigned n_errors;
+    bool metadata_done;
+    
+protected:
+    typedef std::chrono::steady_clock clock;
+    
+    FILE* fp;
+    double lookback;        // Seconds before the end of the file to start from (<0 = start of file)
+    bool skip_frame;        // A frame's CRC didn't match...
+    FLAC__uint64 bad_sample;    // ...and this is where it started
+    std::vector<FLAC__int32> pending; // Frames after a gap, for the next chunk
+    FLAC__uint64 pending_first;
+    bool gap;               // Stop the current chunk; the rest is in pending
+    clock::time_point deadline;
+    
+    // While start_from_lookback() measures the compression ratio
+    bool measuring;
+    bool measured;
+    FLAC__uint64 measured_sample;   // Sample after the measured frame
+    FLAC__uint64 measured_end;      // Byte offset after the measured frame
+    bool resyncing;         // Seeked mid-frame on purpose; errors until the next frame are expected
+    
+    void start_from_lookback(void) {
+        /* Jump to roughly lookback seconds before the end of the file. 
+         * Start from the uncompressed size of that much audio, which is 
+         * at least that far back, and decode one frame there. Its sample
+         * number and position give the bytes per sample so far, which 
+         * says how far back to go. libFLAC finds the next frame from 
+         * wherever we land.
+         */
+        FLAC__uint64 audio_start = 0;
+        get_decode_position(&audio_start);
+        frame_end = audio_start;
+        if(lookback < 0)
+            return;
+        
+        // libFLAC has already read past audio_start, so put fp back if we stay
+        follow_off_t read_position = FOLLOW_FTELL(fp);
+        FOLLOW_FSEEK(fp, 0, SEEK_END);
+        FLAC__uint64 file_size = static_cast<FLAC__uint64>(FOLLOW_FTELL(fp));
+        FLAC__uint64 lookback_bytes = static_cast<FLAC__uint64>(lookback * sample_rate * channels * ((bits_per_sample + 7) / 8));
+        if(file_size <= audio_start + lookback_bytes) {
+            // Start of the file is close enough
+            FOLLOW_FSEEK(fp, read_position, SEEK_SET);
+            return;
+        }
+        frame_end = file_size - lookback_bytes;
+        
+        flush();
+        FOLLOW_FSEEK(fp, static_cast<follow_off_t>(frame_end), SEEK_SET);
+        resyncing = true;
+        
+        measuring = true;
+        measured = false;
+        while(!measured) {
+            bool ok = process_single();
+            FLAC__StreamDecoderState state = get_state();
+            if(!ok || state == FLAC__STREAM_DECODER_ABORTED || state == FLAC__STREAM_DECODER_END_OF_STREAM)
+                break;
+        }
+        measuring = false;
+        skip_frame = false;
+        
+        if(measured && measured_sample > 0 && measured_end > audio_start) {
+            double bytes_per_sample = static_cast<double>(measured_end - audio_start) / measured_sample;
+            FLAC__uint64 compressed_bytes = static_cast<FLAC__uint64>(lookback * sample_rate * bytes_per_sample);
+            if(file_size > audio_start + compressed_bytes)
+                frame_end = std::max(frame_end, file_size - compressed_bytes);
+        }
+        
+        flush();
+        FOLLOW_FSEEK(fp, static_cast<follow_off_t>(frame_end), SEEK_SET);
+        resyncing = true;
+    }
+    
+    ::FLAC__StreamDecoderReadStatus read_callback(FLAC__byte data[], size_t *n_bytes) {
+        while(true) {
+            size_t n = fread(data, 1, *n_bytes, fp);
+            if(n > 0) {
+                *n_bytes = n;
+                return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+            }
+            if(ferror(fp)) {
+                *n_bytes = 0;
+                return FLAC__STREAM_DECODER_READ_STATUS_ABORT;
+            }
+            
+            // At the end of the file (for now). Clear EOF so we see it grow.
+            clearerr(fp);
+            auto now = clock::now();
+            if(now >= deadline) {
+                *n_bytes = 0;
+                return FLAC__STREAM_DECODER_READ_STATUS_ABORT;
+            }
+            std::this_thread::sleep_for(std::min<clock::duration>(deadline - now, std::chrono::milliseconds(5)));
+        }
+    }
+    
+    ::FLAC__StreamDecoderTellStatus tell_callback(FLAC__uint64 *absolute_byte_offset) {
+        // Needed for get_decode_position()
+        *absolute_byte_offset = static_cast<FLAC__uint64>(FOLLOW_FTELL(fp));
+        return FLAC__STREAM_DECODER_TELL_STATUS_OK;
+    }
+    
+    ::FLAC__StreamDecoderWriteStatus write_callback(const ::FLAC__Frame *frame, const FLAC__int32 * const data[]) {
+        FLAC__uint64 sample = frame->header.number.sample_number;
+        FLAC__uint64 position = 0;
+        bool have_position = get_decode_position(&position);
+        resyncing = false;
+        
+        if(measuring) {
+            // Just looking; start_from_lookback() seeks back before this frame
+            measured = have_position;
+            measured_sample = sample + frame->header.blocksize;
+            measured_end = position;
+            return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+        }
+        
+        if(have_position)
+            frame_end = position;
+        
+        // Some libFLAC versions pass on the bad frame (zeroed) after a CRC
+        // mismatch; others drop it
+        bool bad = skip_frame && sample == bad_sample;
+        skip_frame = false;
+        if(bad)
+            return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+        
+        // Keep the output contiguous: after a gap, save this frame for 
+        // the next chunk and stop here
+        std::vector<FLAC__int32>* out = &buffer;
+        if(buffer.empty()) {
+            first_sample = sample;
+        } else if(sample != next_sample) {
+            out = &pending;
+            pending_first = sample;
+            gap = true;
+        }
+        
+        for(unsigned i = 0; i < frame->header.blocksize; i++) {
+            for(unsigned c = 0; c < frame->header.channels; c++) {
+                out->push_back(data[c][i]);
+            }
+        }
+        next_sample = sample + frame->header.blocksize;
+        
+        // Got something, so don't wait around for more
+        deadline = clock::now();
+        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+    }
+    
+    void metadata_callback(const ::FLAC__StreamMetadata *metadata) {
+        if(metadata->type == FLAC__METADATA_TYPE_STREAMINFO) {
+            channels = metadata->data.stream_info.channels;
+            sample_rate = metadata->data.stream_info.sample_rate;
+            bits_per_sample = metadata->data.stream_info.bits_per_sample;
+        }
+    }
+    
+    void error_callback(::FLAC__StreamDecoderErrorStatus status) {
+        // Losing sync after our own seeks isn't a problem with the file
+        if(!measuring && !resyncing)
+            n_errors++;
+        
+        // The bad frame would have started where the last good one ended
+        if(status == FLAC__STREAM_DECODER_ERROR_STATUS_FRAME_CRC_MISMATCH) {
+            skip_frame = true;
+            bad_sample = next_sample;
+        }
+    }
+};
+
+
 
 void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) {
     char cmd[64];
@@ -101,6 +583,26 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) {
         return;
     }
     
+    if (!strcmp("interface_version", cmd)) {
+        plhs[0] = mxCreateDoubleScalar(INTERFACE_VERSION);
+        return;
+    }
+    
+    // Stateless batch commands (these take filenames, not a handle)
+    if (!strcmp("probe", cmd)) {
+        probe(nlhs, nrhs, plhs, prhs);
+        return;
+    } else if (!strcmp("verify", cmd)) {
+        verify(nlhs, nrhs, plhs, prhs);
+        return;
+    } else if (!strncmp("concat_", cmd, 7)) {
+        concat_ops(nlhs, nrhs, plhs, prhs, cmd);
+        return;
+    } else if (!strncmp("follow_", cmd, 7)) {
+        follow_ops(nlhs, nrhs, plhs, prhs, cmd);
+        return;
+    }
+    
     if (nrhs < 2) {
 		mexErrMsgTxt("Second input should be a class instance handle.");
     }
@@ -368,4 +870,554 @@ void is_valid(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[], Buffer
     }
     
     plhs[0] = mxCreateLogicalScalar(static_cast<bool>(decoder->is_valid()));
-}
\ No newline at end of file
+}
+
+
+std::vector<std::string> get_filenames(const mxArray* arg) {
+    /* Accepts either a single filename or a cell array of them */
+    std::vector<std::string> filenames;
+    if(mxIsChar(arg)) {
+        char* str = mxArrayToString(arg);
+        filenames.push_back(str);
+        mxFree(str);
+    } else if(mxIsCell(arg)) {
+        for(mwIndex i = 0; i < mxGetNumberOfElements(arg); i++) {
+            const mxArray* cell = mxGetCell(arg, i);
+            char* str = cell ? mxArrayToString(cell) : NULL;
+            if(!str)
+                mexErrMsgIdAndTxt("FileDecoder:Internal:FilenameArgs", 
+                        "Filename #%d cannot be converted to a string", static_cast<int>(i+1));
+            filenames.push_back(str);
+            mxFree(str);
+        }
+    } else {
+        mexErrMsgIdAndTxt("FileDecoder:Internal:FilenameArgs", 
+                "Filenames must be a string or a cell array of strings");
+    }
+    return filenames;
+}
+
+
+struct ProbeResult {
+    bool ok;
+    std::string message;
+    unsigned sample_rate;
+    unsigned channels;
+    unsigned bits_per_sample;
+    unsigned min_blocksize;
+    unsigned max_blocksize;
+    FLAC__uint64 total_samples;
+    FLAC__byte md5sum[16];
+    unsigned seek_points;     // Zero if there's no SEEKTABLE
+    bool has_seektable;
+    std::string vendor;
+    std::vector<std::string> comments;
+};
+
+static mxArray* utf8_bytes(const std::string& s) {
+    /* Tags are UTF-8, but mxCreateString uses the locale's encoding, so 
+     * hand over the raw bytes and let native2unicode sort them out.
+     */
+    mxArray* out = mxCreateNumericMatrix(1, s.size(), mxUINT8_CLASS, mxREAL);
+    if(!s.empty())
+        memcpy(mxGetData(out), s.data(), s.size());
+    return out;
+}
+
+static void probe_file(const std::string& filename, ProbeResult& r) {
+    /* Walk the metadata blocks with the (read-only) simple iterator, which
+     * skips over anything we don't ask for and never touches the audio.
+     */
+    r.ok = false;
+    r.has_seektable = false;
+    r.seek_points = 0;
+    
+    FLAC::Metadata::SimpleIterator it;
+    if(!it.is_valid() || !it.init(filename.c_str(), true, false)) {
+        r.message = it.status().as_cstring();
+        return;
+    }
+
+    do {
+        switch(it.get_block_type()) {
+            case FLAC__METADATA_TYPE_STREAMINFO: {
+                FLAC::Metadata::Prototype* block = it.get_block();
+                FLAC::Metadata::StreamInfo* info = dynamic_cast<FLAC::Metadata::StreamInfo*>(block);
+                if(info) {
+                    r.ok = true;
+                    r.sample_rate = info->get_sample_rate();
+                    r.channels = info->get_channels();
+                    r.bits_per_sample = info->get_bits_per_sample();
+                    r.min_blocksize = info->get_min_blocksize();
+                    r.max_blocksize = info->get_max_blocksize();
+                    r.total_samples = info->get_total_samples();
+                    memcpy(r.md5sum, info->get_md5sum(), sizeof(r.md5sum));
+                }
+                delete block;
+                break;
+            }
+            
+            case FLAC__METADATA_TYPE_SEEKTABLE:
+                // Each seek point is 18 bytes, so no need to actually read it
+                r.has_seektable = true;
+                r.seek_points = it.get_block_length() / 18;
+                break;
+                
+            case FLAC__METADATA_TYPE_VORBIS_COMMENT: {
+                FLAC::Metadata::Prototype* block = it.get_block();
+                FLAC::Metadata::VorbisComment* tags = dynamic_cast<FLAC::Metadata::VorbisComment*>(block);
+                if(tags) {
+                    r.vendor = reinterpret_cast<const char*>(tags->get_vendor_string());
+                    for(unsigned i = 0; i < tags->get_num_comments(); i++) {
+                        FLAC::Metadata::VorbisComment::Entry entry = tags->get_comment(i);
+                        r.comments.push_back(std::string(entry.get_field(), entry.get_field_length()));
+                    }
+                }
+                delete block;
+                break;
+            }
+            
+            default:
+                break;
+        }
+    } while(it.next());
+    
+    if(!r.ok)
+        r.message = "No STREAMINFO block found";
+}
+
+void probe(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[]) {
+    /* Read the metadata (but no audio) from many files in parallel
+     *  Inputs: filename or cell array of filenames, number of threads (0 = all cores)
+     *  Output: struct array with one element per file
+     */
+    if(nlhs > 1 || nrhs < 2 || nrhs > 3) {
+        mexErrMsgIdAndTxt("FileDecoder:Internal:ProbeArgs",
+                "probe takes a list of files and (optionally) a thread count, and returns one struct array, but nlhs= %d and nrhs=%d.", nlhs, nrhs);
+    }
+    
+    std::vector<std::string> filenames = get_filenames(prhs[1]);
+    unsigned n_threads = (nrhs > 2) ? static_cast<unsigned>(mxGetScalar(prhs[2])) : 0;
+    
+    std::vector<ProbeResult> results(filenames.size());
+    std::vector<std::string> errors = parallel_for(filenames.size(), n_threads, [&](size_t i) {
+        probe_file(filenames[i], results[i]);
+    });
+    for(size_t i = 0; i < errors.size(); i++) {
+        if(!errors[i].empty()) {
+            results[i].ok = false;
+            results[i].message = errors[i];
+        }
+    }
+    
+    // Package it up as a struct
+    static const char* fieldnames[] = {"filename", "ok", "message", "sample_rate", "channels",
+        "bits_per_sample", "total_samples", "duration", "min_blocksize", "max_blocksize", "md5",
+        "has_seektable", "seek_points", "vendor", "comments"};
+    const int n_fields = 15;
+    plhs[0] = mxCreateStructMatrix(filenames.size(), 1, n_fields, fieldnames);
+    
+    for(mwIndex i = 0; i < results.size(); i++) {
+        const ProbeResult& r = results[i];
+        mxSetFieldByNumber(plhs[0], i, 0, mxCreateString(filenames[i].c_str()));
+        mxSetFieldByNumber(plhs[0], i, 1, mxCreateLogicalScalar(r.ok));
+        mxSetFieldByNumber(plhs[0], i, 2, mxCreateString(r.message.c_str()));
+        if(!r.ok)
+            continue; // Leave the rest empty
+        
+        mxSetFieldByNumber(plhs[0], i, 3, mxCreateDoubleScalar(r.sample_rate));
+        mxSetFieldByNumber(plhs[0], i, 4, mxCreateDoubleScalar(r.channels));
+        mxSetFieldByNumber(plhs[0], i, 5, mxCreateDoubleScalar(r.bits_per_sample));
+        
+        mxArray* tmp = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+        *((uint64_T*)(mxGetData(tmp))) = static_cast<uint64_T>(r.total_samples);
+        mxSetFieldByNumber(plhs[0], i, 6, tmp);
+        
+        // Zero total_samples means "unknown", not an empty file
+        double duration = (r.total_samples > 0 && r.sample_rate > 0) ? 
+                static_cast<double>(r.total_samples) / r.sample_rate : mxGetNaN();
+        mxSetFieldByNumber(plhs[0], i, 7, mxCreateDoubleScalar(duration));
+        mxSetFieldByNumber(plhs[0], i, 8, mxCreateDoubleScalar(r.min_blocksize));
+        mxSetFieldByNumber(plhs[0], i, 9, mxCreateDoubleScalar(r.max_blocksize));
+        
+        char md5[33];
+        for(int b = 0; b < 16; b++)
+            snprintf(md5 + 2*b, 3, "%02x", r.md5sum[b]);
+        mxSetFieldByNumber(plhs[0], i, 10, mxCreateString(md5));
+        
+        mxSetFieldByNumber(plhs[0], i, 11, mxCreateLogicalScalar(r.has_seektable));
+        mxSetFieldByNumber(plhs[0], i, 12, mxCreateDoubleScalar(r.seek_points));
+        mxSetFieldByNumber(plhs[0], i, 13, utf8_bytes(r.vendor));
+        
+        mxArray* comments = mxCreateCellMatrix(r.comments.size(), 1);
+        for(mwIndex c = 0; c < r.comments.size(); c++)
+            mxSetCell(comments, c, utf8_bytes(r.comments[c]));
+        mxSetFieldByNumber(plhs[0], i, 14, comments);
+    }
+}
+
+
+struct VerifyResult {
+    bool ok;
+    std::string message;
+    bool md5_checked;
+    bool md5_ok;
+    FLAC__uint64 total_samples;
+    FLAC__uint64 n_samples;
+    FLAC__uint64 n_bytes;
+    double seconds;
+    std::vector<FLAC__uint64> error_samples;
+    std::vector<FLAC__StreamDecoderErrorStatus> error_codes;
+};
+
+static void verify_file(const std::string& filename, VerifyResult& r) {
+    /* Decode one file, checking frame CRCs and the MD5 signature.
+     */
+    typedef std::chrono::steady_clock clock;
+    r.ok = false;
+    r.md5_checked = false;
+    r.md5_ok = false;
+    r.total_samples = r.n_samples = r.n_bytes = 0;
+    r.seconds = 0;
+    
+    VerifyDecoder decoder;
+    decoder.set_md5_checking(true);
+    
+    auto start = clock::now();
+    FLAC__StreamDecoderInitStatus status = decoder.init(filename.c_str());
+    if(status != FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+        r.message = FLAC__StreamDecoderInitStatusString[status];
+        return;
+    }
+    
+    bool decoded = decoder.process_until_end_of_stream();
+    if(!decoded) 
+        r.message = decoder.get_state().as_cstring();
+    
+    FLAC__uint64 position = 0;
+    if(decoder.get_decode_position(&position))
+        r.n_bytes = position;
+    
+    // finish() is where libFLAC compares the MD5 signatures 
+    r.md5_ok = decoder.finish();
+    r.seconds = std::chrono::duration<double>(clock::now() - start).count();
+    
+    r.md5_checked = decoder.has_md5;
+    r.total_samples = decoder.total_samples;
+    r.n_samples = decoder.n_samples;
+    r.error_samples.swap(decoder.error_samples);
+    r.error_codes.swap(decoder.error_codes);
+    
+    bool complete = (r.total_samples == 0) || (r.n_samples == r.total_samples);
+    if(decoded && !complete)
+        r.message = "Number of decoded samples does not match STREAMINFO";
+    else if(decoded && r.md5_checked && !r.md5_ok)
+        r.message = "MD5 signature mismatch";
+    else if(decoded && !r.error_codes.empty())
+        r.message = "Decoding errors";
+    
+    r.ok = decoded && complete && (r.md5_ok || !r.md5_checked) && r.error_codes.empty();
+}
+
+void verify(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[]) {
+    /* Check the integrity of many files in parallel, without returning data
+     *  Inputs: filename or cell array of filenames, number of threads (0 = all cores)
+     *  Output: struct array with one element per file
+     */
+    if(nlhs > 1 || nrhs < 2 || nrhs > 3) {
+        mexErrMsgIdAndTxt("FileDecoder:Internal:VerifyArgs",
+                "verify takes a list of files and (optionally) a thread count, and returns one struct array, but nlhs= %d and nrhs=%d.", nlhs, nrhs);
+    }
+    
+    std::vector<std::string> filenames = get_filenames(prhs[1]);
+    unsigned n_threads = (nrhs > 2) ? static_cast<unsigned>(mxGetScalar(prhs[2])) : 0;
+    
+    std::vector<VerifyResult> results(filenames.size());
+    std::vector<std::string> errors = parallel_for(filenames.size(), n_threads, [&](size_t i) {
+        verify_file(filenames[i], results[i]);
+    });
+    for(size_t i = 0; i < errors.size(); i++) {
+        if(!errors[i].empty()) {
+            results[i].ok = false;
+            results[i].message = errors[i];
+        }
+    }
+    
+    // Package it up as a struct
+    static const char* fieldnames[] = {"filename", "ok", "message", "md5_checked", "md5_ok",
+        "total_samples", "samples_decoded", "n_errors", "error_samples", "error_types",
+        "seconds", "samples_per_sec", "bytes_per_sec"};
+    const int n_fields = 13;
+    plhs[0] = mxCreateStructMatrix(filenames.size(), 1, n_fields, fieldnames);
+    
+    for(mwIndex i = 0; i < results.size(); i++) {
+        const VerifyResult& r = results[i];
+        mxSetFieldByNumber(plhs[0], i, 0, mxCreateString(filenames[i].c_str()));
+        mxSetFieldByNumber(plhs[0], i, 1, mxCreateLogicalScalar(r.ok));
+        mxSetFieldByNumber(plhs[0], i, 2, mxCreateString(r.message.c_str()));
+        mxSetFieldByNumber(plhs[0], i, 3, mxCreateLogicalScalar(r.md5_checked));
+        mxSetFieldByNumber(plhs[0], i, 4, mxCreateLogicalScalar(r.md5_checked && r.md5_ok));
+        
+        mxArray* tmp = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+        *((uint64_T*)(mxGetData(tmp))) = static_cast<uint64_T>(r.total_samples);
+        mxSetFieldByNumber(plhs[0], i, 5, tmp);
+        
+        tmp = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+        *((uint64_T*)(mxGetData(tmp))) = static_cast<uint64_T>(r.n_samples);
+        mxSetFieldByNumber(plhs[0], i, 6, tmp);
+        
+        mxSetFieldByNumber(plhs[0], i, 7, mxCreateDoubleScalar(static_cast<double>(r.error_codes.size())));
+        
+        // Error positions are (zero-indexed) samples, like seek_absolute
+        tmp = mxCreateNumericMatrix(r.error_samples.size(), 1, mxUINT64_CLASS, mxREAL);
+        uint64_T* positions = static_cast<uint64_T*>(mxGetData(tmp));
+        for(size_t e = 0; e < r.error_samples.size(); e++)
+            positions[e] = static_cast<uint64_T>(r.error_samples[e]);
+        mxSetFieldByNumber(plhs[0], i, 8, tmp);
+        
+        tmp = mxCreateCellMatrix(r.error_codes.size(), 1);
+        for(size_t e = 0; e < r.error_codes.size(); e++)
+            mxSetCell(tmp, e, mxCreateString(FLAC__StreamDecoderErrorStatusString[r.error_codes[e]]));
+        mxSetFieldByNumber(plhs[0], i, 9, tmp);
+        
+        bool timed = r.seconds > 0;
+        mxSetFieldByNumber(plhs[0], i, 10, mxCreateDoubleScalar(r.seconds));
+        mxSetFieldByNumber(plhs[0], i, 11, mxCreateDoubleScalar(timed ? r.n_samples / r.seconds : mxGetNaN()));
+        mxSetFieldByNumber(plhs[0], i, 12, mxCreateDoubleScalar(timed ? r.n_bytes / r.seconds : mxGetNaN()));
+    }
+}
+
+
+static ConcatDecoder* new_concat_decoder(const std::vector<std::string>& filenames, size_t cache_size, unsigned n_threads) {
+    /* Check that the files can be stitched together (same format, known 
+     * lengths) before building a ConcatDecoder out of them.
+     */
+    if(filenames.empty())
+        mexErrMsgIdAndTxt("FileDecoder:Concat:NoFiles", "At least one file is required");
+    
+    std::vector<ProbeResult> info(filenames.size());
+    std::vector<std::string> errors = parallel_for(filenames.size(), n_threads, [&](size_t i) {
+        probe_file(filenames[i], info[i]);
+    });
+    for(size_t i = 0; i < errors.size(); i++) {
+        if(!errors[i].empty()) {
+            info[i].ok = false;
+            info[i].message = errors[i];
+        }
+    }
+    
+    std::vector<FLAC__uint64> lengths;
+    for(size_t f = 0; f < filenames.size(); f++) {
+        if(!info[f].ok) {
+            mexErrMsgIdAndTxt("FileDecoder:Concat:FileError", "Unable to read %s: %s", 
+                    filenames[f].c_str(), info[f].message.c_str());
+        }
+        if(info[f].total_samples == 0) {
+            mexErrMsgIdAndTxt("FileDecoder:Concat:UnknownLength", 
+                    "%s does not record its length in STREAMINFO (is it still being written?)", filenames[f].c_str());
+        }
+        if(info[f].channels != info[0].channels || info[f].sample_rate != info[0].sample_rate || 
+                info[f].bits_per_sample != info[0].bits_per_sample) {
+            mexErrMsgIdAndTxt("FileDecoder:Concat:Mismatch", 
+                    "%s has a different channel count, sample rate, or bit depth than %s", 
+                    filenames[f].c_str(), filenames[0].c_str());
+        }
+        lengths.push_back(info[f].total_samples);
+    }
+    
+    return new ConcatDecoder(filenames, lengths, info[0].channels, info[0].sample_rate, 
+            info[0].bits_per_sample, cache_size);
+}
+
+void concat_ops(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[], const char* cmd) {
+    /* Commands for MultiFileDecoder:
+     - concat_new: Open a list of files (plus cache size, number of threads)
+     - concat_delete: Close all the files
+     - concat_get_info: Return a struct describing the combined stream
+     - concat_seek_absolute: Seek to a (zero-indexed) global sample
+     - concat_read: Read n samples starting at a (zero-indexed) global sample
+    */
+    if(!strcmp(cmd, "concat_new")) {
+        if(nlhs != 1 || nrhs != 4) {
+            mexErrMsgIdAndTxt("FileDecoder:Internal:ConcatArgs",
+                    "concat_new takes filenames, a cache size, and a thread count, and returns a handle");
+        }
+        std::vector<std::string> filenames = get_filenames(prhs[1]);
+        plhs[0] = convertPtr2Mat<ConcatDecoder>(new_concat_decoder(filenames, 
+                static_cast<size_t>(mxGetScalar(prhs[2])), static_cast<unsigned>(mxGetScalar(prhs[3]))));
+        return;
+    }
+    
+    if(nrhs < 2) {
+		mexErrMsgTxt("Second input should be a class instance handle.");
+    }
+    
+    if(!strcmp(cmd, "concat_delete")) {
+        destroyObject<ConcatDecoder>(prhs[1]);
+        if (nlhs != 0 || nrhs != 2)
+            mexWarnMsgTxt("Delete: Unexpected arguments ignored.");
+        return;
+    }
+    
+    ConcatDecoder* decoder = convertMat2Ptr<ConcatDecoder>(prhs[1]);
+    
+    if(!strcmp(cmd, "concat_get_info")) {
+        if(nlhs > 1 || nrhs != 2) {
+            mexErrMsgIdAndTxt("FileDecoder:Internal:ConcatArgs",
+                    "concat_get_info takes no arguments and returns one struct");
+        }
+        
+        static const char* fieldnames[] = {"filenames", "starts", "total_samples", "channels",
+            "sample_rate", "bits_per_sample", "cache_size", "position"};
+        const int n_fields = 8;
+        plhs[0] = mxCreateStructMatrix(1, 1, n_fields, fieldnames);
+        
+        mxArray* tmp = mxCreateCellMatrix(decoder->filenames.size(), 1);
+        for(size_t f = 0; f < decoder->filenames.size(); f++)
+            mxSetCell(tmp, f, mxCreateString(decoder->filenames[f].c_str()));
+        mxSetFieldByNumber(plhs[0], 0, 0, tmp);
+        
+        // One fewer than starts, since the last element is the total
+        tmp = mxCreateNumericMatrix(decoder->filenames.size(), 1, mxUINT64_CLASS, mxREAL);
+        uint64_T* starts = static_cast<uint64_T*>(mxGetData(tmp));
+        for(size_t f = 0; f < decoder->filenames.size(); f++)
+            starts[f] = static_cast<uint64_T>(decoder->starts[f]);
+        mxSetFieldByNumber(plhs[0], 0, 1, tmp);
+        
+        tmp = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+        *((uint64_T*)(mxGetData(tmp))) = static_cast<uint64_T>(decoder->get_total_samples());
+        mxSetFieldByNumber(plhs[0], 0, 2, tmp);
+        
+        mxSetFieldByNumber(plhs[0], 0, 3, mxCreateDoubleScalar(decoder->channels));
+        mxSetFieldByNumber(plhs[0], 0, 4, mxCreateDoubleScalar(decoder->sample_rate));
+        mxSetFieldByNumber(plhs[0], 0, 5, mxCreateDoubleScalar(decoder->bits_per_sample));
+        mxSetFieldByNumber(plhs[0], 0, 6, mxCreateDoubleScalar(static_cast<double>(decoder->cache_size)));
+        
+        tmp = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+        *((uint64_T*)(mxGetData(tmp))) = static_cast<uint64_T>(decoder->position);
+        mxSetFieldByNumber(plhs[0], 0, 7, tmp);
+        
+    } else if(!strcmp(cmd, "concat_seek_absolute")) {
+        if(nlhs > 1 || nrhs != 3) {
+            mexErrMsgIdAndTxt("FileDecoder:Internal:SeekArgs", 
+                 "seek_absolute takes one argument (plus obj/command inputs), but nlhs= %d and nrhs=%d.", nlhs, nrhs);
+        }
+        plhs[0] = mxCreateLogicalScalar(decoder->seek_absolute(static_cast<FLAC__uint64>(mxGetScalar(prhs[2]))));
+        
+    } else if(!strcmp(cmd, "concat_read")) {
+        if(nlhs > 1 || nrhs != 4) {
+            mexErrMsgIdAndTxt("FileDecoder:Internal:ConcatArgs",
+                    "concat_read takes a start sample and a sample count, and returns one matrix");
+        }
+        
+        FLAC__uint64 start = static_cast<FLAC__uint64>(mxGetScalar(prhs[2]));
+        FLAC__uint64 n_samples = static_cast<FLAC__uint64>(mxGetScalar(prhs[3]));
+        if(start + n_samples > decoder->get_total_samples()) {
+            mexErrMsgIdAndTxt("FileDecoder:Concat:OutOfRange", 
+                    "Requested samples run past the end of the last file");
+        }
+        
+        // Decode straight into the output array; no stitching required
+        plhs[0] = mxCreateUninitNumericMatrix(decoder->channels, static_cast<mwSize>(n_samples), mxINT32_CLASS, mxREAL);
+        if(!decoder->read(start, n_samples, static_cast<FLAC__int32*>(mxGetData(plhs[0])))) {
+            mxDestroyArray(plhs[0]);
+            mexErrMsgIdAndTxt("FileDecoder:Concat:ReadError", "Unable to decode the requested samples");
+        }
+        
+    } else {
+        mexErrMsgIdAndTxt("FileDecoder:UnknownCommand", "Unknown command!");
+    }
+}
+
+
+void follow_ops(int nlhs, int nrhs, mxArray* plhs[], const mxArray* prhs[], const char* cmd) {
+    /* Commands for FollowDecoder:
+     - follow_new: Open a file (plus lookback in seconds; negative = from the start)
+     - follow_delete: Close the file
+     - follow_get_info: Return a struct describing the stream and progress
+     - follow_next_chunk: Decode new frames (timeout in seconds, max samples)
+    */
+    if(!strcmp(cmd, "follow_new")) {
+        if(nlhs != 1 || nrhs != 3) {
+            mexErrMsgIdAndTxt("FileDecoder:Internal:FollowArgs",
+                    "follow_new takes a filename and a lookback, and returns a handle");
+        }
+        
+        char* filename = mxArrayToString(prhs[1]);
+        if(!filename)
+            mexErrMsgIdAndTxt("FileDecoder:Internal:InitArgs", 
+                "Filename cannot be converted to a string");
+        
+        FILE* fp = fopen(filename, "rb");
+        if(!fp) {
+            mexErrMsgIdAndTxt("FileDecoder:FileError", "Unable to open file %s", filename);
+        }
+        mxFree(filename);
+        
+        FollowDecoder* decoder = new FollowDecoder(fp, mxGetScalar(prhs[2]));
+        if(decoder->init() != FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+            delete decoder;
+            mexErrMsgIdAndTxt("FileDecoder:MemoryError", "Unable to initialize decoder");
+        }
+        plhs[0] = convertPtr2Mat<FollowDecoder>(decoder);
+        return;
+    }
+    
+    if(nrhs < 2) {
+		mexErrMsgTxt("Second input should be a class instance handle.");
+    }
+    
+    if(!strcmp(cmd, "follow_delete")) {
+        destroyObject<FollowDecoder>(prhs[1]);
+        if (nlhs != 0 || nrhs != 2)
+            mexWarnMsgTxt("Delete: Unexpected arguments ignored.");
+        return;
+    }
+    
+    FollowDecoder* decoder = convertMat2Ptr<FollowDecoder>(prhs[1]);
+    
+    if(!strcmp(cmd, "follow_get_info")) {
+        if(nlhs > 1 || nrhs != 2) {
+            mexErrMsgIdAndTxt("FileDecoder:Internal:FollowArgs",
+                    "follow_get_info takes no arguments and returns one struct");
+        }
+        
+        static const char* fieldnames[] = {"ready", "channels", "sample_rate", "bits_per_sample",
+            "position", "bytes_decoded", "n_errors"};
+        const int n_fields = 7;
+        plhs[0] = mxCreateStructMatrix(1, 1, n_fields, fieldnames);
+        
+        mxSetFieldByNumber(plhs[0], 0, 0, mxCreateLogicalScalar(decoder->metadata_done));
+        mxSetFieldByNumber(plhs[0], 0, 1, mxCreateDoubleScalar(decoder->channels));
+        mxSetFieldByNumber(plhs[0], 0, 2, mxCreateDoubleScalar(decoder->sample_rate));
+        mxSetFieldByNumber(plhs[0], 0, 3, mxCreateDoubleScalar(decoder->bits_per_sample));
+        
+        mxArray* tmp = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+        *((uint64_T*)(mxGetData(tmp))) = static_cast<uint64_T>(decoder->position());
+        mxSetFieldByNumber(plhs[0], 0, 4, tmp);
+        
+        tmp = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+        *((uint64_T*)(mxGetData(tmp))) = static_cast<uint64_T>(decoder->frame_end);
+        mxSetFieldByNumber(plhs[0], 0, 5, tmp);
+        
+        mxSetFieldByNumber(plhs[0], 0, 6, mxCreateDoubleScalar(decoder->n_errors));
+        
+    } else if(!strcmp(cmd, "follow_next_chunk")) {
+        if(nlhs > 2 || nrhs != 4) {
+            mexErrMsgIdAndTxt("FileDecoder:Internal:FollowArgs",
+                    "follow_next_chunk takes a timeout and a maximum number of samples, and returns data and its first sample");
+        }
+        
+        decoder->next_chunk(mxGetScalar(prhs[2]), static_cast<size_t>(mxGetScalar(prhs[3])));
+        plhs[0] = decoder->to_mxArray();
+        if(nlhs > 1) {
+            // Zero-indexed, like seek_absolute
+            plhs[1] = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+            *((uint64_T*)(mxGetData(plhs[1]))) = static_cast<uint64_T>(
+                    decoder->buffer.empty() ? decoder->position() : decoder->first_sample);
+        }
+        
+    } else {
+        mexErrMsgIdAndTxt("FileDecoder:UnknownCommand", "Unknown command!");
+    }
+}
@@ -1,13 +1,186 @@
 #include "mex.h"
 #include "matrix.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
 #include "class_handle.hpp"
+#include "parallel_for.hpp"
 
 #include <FLAC++/encoder.h>
+#include <FLAC++/decoder.h>
+#include <FLAC++/metadata.h>
+
+/* Checked by private/check_interface.m, so stale binaries fail loudly instead
+ * of ignoring commands they don't know. Bump it (here and in the other
+ * interface) whenever commands are added.
+ */
+static const int INTERFACE_VERSION = 2;
 
 void generic_getters(int nlhs, mxArray *plhs[], int nrhs, const char* cmd, FLAC::Encoder::File *encoder);
 void generic_setters(int nlhs, int nrhs, const mxArray *plhs[], const char* cmd, FLAC::Encoder::File *encoder);
 void get_verify_decoder_error_stats(int lhs, mxArray* plhs[], int nrhs, FLAC::Encoder::File* encoder);             
+void autotune(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[], FLAC::Encoder::File* encoder);
+
+class MetadataEncoder;
+void set_metadata(int nlhs, int nrhs, const mxArray* prhs[], MetadataEncoder* encoder);
+void update_metadata(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]);
+
+
+class MetadataEncoder: public FLAC::Encoder::File {
+    /* libFLAC doesn't take ownership of the blocks passed to set_metadata,
+     * but they have to stay alive until finish(). This keeps them around.
+     */
+public:
+    MetadataEncoder() : FLAC::Encoder::File() { }
+    
+    ~MetadataEncoder() {
+        finish(); // Before the blocks go away
+        clear_metadata();
+    }
+    
+    bool set_metadata_blocks(std::vector<FLAC::Metadata::Prototype*>& new_blocks) {
+        /* Takes ownership of the blocks in new_blocks (and empties it) */
+        clear_metadata();
+        blocks.swap(new_blocks);
+        if(blocks.empty())
+            return FLAC::Encoder::File::set_metadata(static_cast<FLAC::Metadata::Prototype**>(NULL), 0);
+        return FLAC::Encoder::File::set_metadata(blocks.data(), static_cast<unsigned>(blocks.size()));
+    }
+    
+protected:
+    std::vector<FLAC::Metadata::Prototype*> blocks;
+    
+    void clear_metadata(void) {
+        for(auto block : blocks)
+            delete block;
+        blocks.clear();
+    }
+};
+
+
+struct MetadataSpec {
+    /* Metadata pulled out of MATLAB's arguments, before any blocks are built */
+    struct App {
+        FLAC__byte id[4];
+        std::vector<FLAC__byte> data;
+    };
+    
+    std::vector<std::string> comments; // NAME=value
+    std::vector<App> applications;
+    long padding;                      // Bytes; negative means no PADDING block
+};
+
+
+class MemoryEncoder: public FLAC::Encoder::Stream {
+    /* Encodes into a std::vector instead of a file. Used by autotune to
+     * try out settings without touching the disk. There's no seek callback,
+     * so STREAMINFO isn't rewritten at the end, which is fine for this.
+     */
+public:
+    MemoryEncoder() : FLAC::Encoder::Stream() { }
+
+    std::vector<FLAC__byte> bytes;
+
+protected:
+    ::FLAC__StreamEncoderWriteStatus write_callback(const FLAC__byte buffer[], size_t n_bytes, unsigned, unsigned) {
+        // Exceptions can't unwind through libFLAC's C code
+        try {
+            bytes.insert(bytes.end(), buffer, buffer + n_bytes);
+        } catch(std::bad_alloc&) {
+            return FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+        }
+        return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+    }
+};
+
+
+class MemoryDecoder: public FLAC::Decoder::Stream {
+    /* Decodes a MemoryEncoder's output, counting (but not keeping) the
+     * samples so that autotune can time decoding on its own.
+     */
+public:
+    MemoryDecoder(const std::vector<FLAC__byte>& src) : FLAC::Decoder::Stream(), 
+        n_samples(0), n_errors(0), src(src), pos(0) { }
+
+    FLAC__uint64 n_samples;
+    unsigned n_errors;
+
+protected:
+    const std::vector<FLAC__byte>& src;
+    size_t pos;
+
+    ::FLAC__StreamDecoderReadStatus read_callback(FLAC__byte buffer[], size_t *n_bytes) {
+        if(pos >= src.size()) {
+            *n_bytes = 0;
+            return FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
+        }
+
+        size_t n = std::min(*n_bytes, src.size() - pos);
+        memcpy(buffer, src.data() + pos, n);
+        pos += n;
+        *n_bytes = n;
+        return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+    }
+
+    ::FLAC__StreamDecoderWriteStatus write_callback(const ::FLAC__Frame *frame, const FLAC__int32 * const []) {
+        n_samples += frame->header.blocksize;
+        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+    }
+
+    void error_callback(::FLAC__StreamDecoderErrorStatus) {
+        n_errors++;
+    }
+};
+
+
+struct TuneConfig {
+    /* One point in autotune's search space. Negative values (or an empty
+     * apodization string) leave that parameter alone.
+     */
+    int compression_level;
+    int blocksize;
+    std::string apodization;
+    int max_lpc_order;
+    int qlp_coeff_precision;
+    int min_residual_partition_order;
+    int max_residual_partition_order;
+};
+
+struct TuneSettings {
+    /* Everything autotune copies from the user's encoder. base holds the
+     * encoder's current values for the tunable parameters, which are used
+     * when a candidate doesn't specify a compression level.
+     */
+    unsigned channels;
+    unsigned bits_per_sample;
+    unsigned sample_rate;
+    bool streamable_subset;
+    bool mid_side_stereo;
+    bool loose_mid_side_stereo;
+    bool qlp_coeff_prec_search;
+    bool exhaustive_model_search;
+    TuneConfig base;
+};
+
+struct TuneSlice {
+    const FLAC__int32* data; // Interleaved, straight out of the mxArray
+    unsigned n_samples;      // Per channel
+};
+
+struct TuneResult {
+    bool ok;
+    std::string message;
+    FLAC__uint64 bytes;
+    FLAC__uint64 n_samples;
+    double encode_seconds;
+    double decode_seconds;
+};
 
 void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray *prhs[]) {	
     // Get the command string
@@ -23,7 +196,18 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray *prhs[]) {
         if (nlhs != 1)
             mexErrMsgTxt("New: One output expected.");
         // Return a handle to a new C++ instance
-        plhs[0] = convertPtr2Mat<FLAC::Encoder::File>(new FLAC::Encoder::File);
+        plhs[0] = convertPtr2Mat<MetadataEncoder>(new MetadataEncoder);
+        return;
+    }
+    
+    if (!strcmp("interface_version", cmd)) {
+        plhs[0] = mxCreateDoubleScalar(INTERFACE_VERSION);
+        return;
+    }
+    
+    // Works on a finished file, not an encoder handle
+    if (!strcmp("update_metadata", cmd)) {
+        update_metadata(nlhs, plhs, nrhs, prhs);
         return;
     }
     
@@ -33,13 +217,13 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray *prhs[]) {
     // Delete
     if (!strcmp("delete", cmd)) {
         // Not sure how much of this actually needs to be done, but...
-        FLAC::Encoder::File* encoder = convertMat2Ptr<FLAC::Encoder::File>(prhs[1]);
+        MetadataEncoder* encoder = convertMat2Ptr<MetadataEncoder>(prhs[1]);
         bool ok = encoder->finish();
         if(!ok) {
             mexWarnMsgTxt("Something happened"); //TODO: Real error message
         }
                 
-        destroyObject<FLAC::Encoder::File>(prhs[1]);
+        destroyObject<MetadataEncoder>(prhs[1]);
         // Warn if other commands were ignored
         if (nlhs != 0 || nrhs != 2)
             mexWarnMsgTxt("Delete: Unexpected arguments ignored.");
@@ -47,7 +231,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray *prhs[]) {
     }
 
     // Get the class instance pointer from the second input
-    FLAC::Encoder::File *encoder = convertMat2Ptr<FLAC::Encoder::File>(prhs[1]);
+    MetadataEncoder *encoder = convertMat2Ptr<MetadataEncoder>(prhs[1]);
   
     /* Process all commands beginning with "get_". 
         The really trivial one-liners are all in getters(), but the 
@@ -87,7 +271,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray *prhs[]) {
     /*Setters here. The meta stuff is complicated so it gets its own function. */
     } else if(!strncmp("set_", cmd, 3)) {
         if(!strcmp("set_metadata", cmd)) {
-           //Some stuff here
+            set_metadata(nlhs, nrhs, prhs, encoder);
         } else {
             generic_setters(nlhs, nrhs, prhs, cmd, encoder);            
         }
@@ -204,6 +388,9 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray *prhs[]) {
             bool ok = encoder->finish();
             plhs[0] = mxCreateLogicalScalar(ok);
             return;
+        } else if(!strcmp("autotune", cmd)) {
+            autotune(nlhs, plhs, nrhs, prhs, encoder);
+            return;
         }
 
             
@@ -356,4 +543,414 @@ void get_verify_decoder_error_stats(int nlhs, mxArray* plhs[], int nrhs, FLAC::E
 
     return;
 }
-                
+
+
+static int get_tune_field(const mxArray* candidates, mwIndex i, const char* name) {
+    /* Reads a numeric field from the candidate struct array. Missing,
+     * empty and NaN fields come back as -1 ("leave it alone").
+     */
+    const mxArray* field = mxGetField(candidates, i, name);
+    if(!field || mxIsEmpty(field))
+        return -1;
+
+    double value = mxGetScalar(field);
+    if(std::isnan(value))
+        return -1;
+    if(value < 0)
+        mexErrMsgIdAndTxt("FileEncoder:Autotune:BadCandidate", 
+                "%s must be non-negative (or NaN), not %f", name, value);
+    return static_cast<int>(value);
+}
+
+static bool configure_candidate(MemoryEncoder& enc, const TuneSettings& settings, const TuneConfig& cfg) {
+    /* Set up enc for one candidate. A compression level replaces the
+     * encoder's current settings with libFLAC's preset, so it goes first 
+     * and anything else the candidate specifies is layered on top.
+     */
+    bool ok = enc.set_channels(settings.channels) &&
+              enc.set_bits_per_sample(settings.bits_per_sample) &&
+              enc.set_sample_rate(settings.sample_rate) &&
+              enc.set_streamable_subset(settings.streamable_subset);
+
+    if(cfg.compression_level >= 0) {
+        ok = ok && enc.set_compression_level(static_cast<unsigned>(cfg.compression_level));
+    } else {
+        const TuneConfig& base = settings.base;
+        ok = ok && enc.set_blocksize(static_cast<unsigned>(base.blocksize)) &&
+                   enc.set_do_mid_side_stereo(settings.mid_side_stereo) &&
+                   enc.set_loose_mid_side_stereo(settings.loose_mid_side_stereo) &&
+                   enc.set_max_lpc_order(static_cast<unsigned>(base.max_lpc_order)) &&
+                   enc.set_qlp_coeff_precision(static_cast<unsigned>(base.qlp_coeff_precision)) &&
+                   enc.set_do_qlp_coeff_prec_search(settings.qlp_coeff_prec_search) &&
+                   enc.set_do_exhaustive_model_search(settings.exhaustive_model_search) &&
+                   enc.set_min_residual_partition_order(static_cast<unsigned>(base.min_residual_partition_order)) &&
+                   enc.set_max_residual_partition_order(static_cast<unsigned>(base.max_residual_partition_order));
+        if(!base.apodization.empty())
+            ok = ok && enc.set_apodization(base.apodization.c_str());
+    }
+
+    if(cfg.blocksize >= 0)
+        ok = ok && enc.set_blocksize(static_cast<unsigned>(cfg.blocksize));
+    if(!cfg.apodization.empty())
+        ok = ok && enc.set_apodization(cfg.apodization.c_str());
+    if(cfg.max_lpc_order >= 0)
+        ok = ok && enc.set_max_lpc_order(static_cast<unsigned>(cfg.max_lpc_order));
+    if(cfg.qlp_coeff_precision >= 0)
+        ok = ok && enc.set_qlp_coeff_precision(static_cast<unsigned>(cfg.qlp_coeff_precision));
+    if(cfg.min_residual_partition_order >= 0)
+        ok = ok && enc.set_min_residual_partition_order(static_cast<unsigned>(cfg.min_residual_partition_order));
+    if(cfg.max_residual_partition_order >= 0)
+        ok = ok && enc.set_max_residual_partition_order(static_cast<unsigned>(cfg.max_residual_partition_order));
+
+    return ok;
+}
+
+static TuneResult run_candidate(const TuneSettings& settings, const TuneConfig& cfg, const std::vector<TuneSlice>& slices) {
+    /* Encode every slice with one candidate's settings, then decode it 
+     * again, timing both. Each slice gets its own stream so slices don't 
+     * bleed into each other.
+     */
+    typedef std::chrono::steady_clock clock;
+    TuneResult result = {true, "", 0, 0, 0.0, 0.0};
+
+    for(size_t s = 0; s < slices.size() && result.ok; s++) {
+        MemoryEncoder enc;
+        if(!configure_candidate(enc, settings, cfg)) {
+            result.ok = false;
+            result.message = "Encoder rejected these settings";
+            break;
+        }
+
+        auto start = clock::now();
+        bool ok = (enc.init() == FLAC__STREAM_ENCODER_INIT_STATUS_OK) &&
+                  enc.process_interleaved(slices[s].data, slices[s].n_samples);
+        ok = enc.finish() && ok;
+        result.encode_seconds += std::chrono::duration<double>(clock::now() - start).count();
+        
+        if(!ok) {
+            result.ok = false;
+            result.message = enc.get_state().as_cstring();
+            break;
+        }
+
+        MemoryDecoder dec(enc.bytes);
+        start = clock::now();
+        ok = (dec.init() == FLAC__STREAM_DECODER_INIT_STATUS_OK) &&
+             dec.process_until_end_of_stream();
+        dec.finish();
+        result.decode_seconds += std::chrono::duration<double>(clock::now() - start).count();
+
+        if(!ok || dec.n_errors > 0 || dec.n_samples != slices[s].n_samples) {
+            result.ok = false;
+            result.message = "Encoded data did not decode cleanly";
+            break;
+        }
+
+        result.bytes += enc.bytes.size();
+        result.n_samples += slices[s].n_samples;
+    }
+    return result;
+}
+
+void autotune(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[], FLAC::Encoder::File* encoder) {
+    /* Benchmark a set of candidate settings on in-memory copies of the data
+     *  Inputs: slices (cell array of n_channels x n int32 matrices),
+     *          candidates (struct array; see TuneConfig for the fields),
+     *          current apodization string, number of threads (0 = all cores)
+     *  Output: struct array with one element per candidate
+     */
+    if(nlhs > 1 || nrhs != 6) {
+        mexErrMsgIdAndTxt("FileEncoder:Internal:AutotuneArgs",
+                "autotune takes four arguments (plus obj/command inputs) and returns one struct array, but nlhs= %d and nrhs=%d.", nlhs, nrhs);
+    }
+
+    if(encoder->get_state() != FLAC__STREAM_ENCODER_UNINITIALIZED) {
+        mexErrMsgIdAndTxt("FileEncoder:AlreadyInit", "autotune() must be called before the encoder is initialized");
+    }
+
+    // Gather everything from MATLAB up front; the workers can't touch it.
+    TuneSettings settings;
+    settings.channels = encoder->get_channels();
+    settings.bits_per_sample = encoder->get_bits_per_sample();
+    settings.sample_rate = encoder->get_sample_rate();
+    settings.streamable_subset = encoder->get_streamable_subset();
+    settings.mid_side_stereo = encoder->get_do_mid_side_stereo();
+    settings.loose_mid_side_stereo = encoder->get_loose_mid_side_stereo();
+    settings.qlp_coeff_prec_search = encoder->get_do_qlp_coeff_prec_search();
+    settings.exhaustive_model_search = encoder->get_do_exhaustive_model_search();
+    settings.base.compression_level = -1;
+    settings.base.blocksize = static_cast<int>(encoder->get_blocksize());
+    settings.base.max_lpc_order = static_cast<int>(encoder->get_max_lpc_order());
+    settings.base.qlp_coeff_precision = static_cast<int>(encoder->get_qlp_coeff_precision());
+    settings.base.min_residual_partition_order = static_cast<int>(encoder->get_min_residual_partition_order());
+    settings.base.max_residual_partition_order = static_cast<int>(encoder->get_max_residual_partition_order());
+    
+    char* apodization = mxArrayToString(prhs[4]);
+    if(apodization) {
+        settings.base.apodization = apodization;
+        mxFree(apodization);
+    }
+
+    if(!mxIsCell(prhs[2])) {
+        mexErrMsgIdAndTxt("FileEncoder:Autotune:ArgType", "Slices must be a cell array of int32 matrices");
+    }
+    std::vector<TuneSlice> slices;
+    for(mwIndex i = 0; i < mxGetNumberOfElements(prhs[2]); i++) {
+        const mxArray* slice = mxGetCell(prhs[2], i);
+        if(!slice || !mxIsInt32(slice) || mxGetM(slice) != settings.channels) {
+            mexErrMsgIdAndTxt("FileEncoder:Autotune:ArgType", 
+                    "Each slice must be a %d (channels) x n_samples int32 matrix", settings.channels);
+        }
+        TuneSlice s = {static_cast<const FLAC__int32*>(mxGetData(slice)), static_cast<unsigned>(mxGetN(slice))};
+        if(s.n_samples > 0)
+            slices.push_back(s);
+    }
+    if(slices.empty()) {
+        mexErrMsgIdAndTxt("FileEncoder:Autotune:NoData", "No data provided to autotune");
+    }
+
+    if(!mxIsStruct(prhs[3])) {
+        mexErrMsgIdAndTxt("FileEncoder:Autotune:ArgType", "Candidates must be a struct array");
+    }
+    std::vector<TuneConfig> candidates(mxGetNumberOfElements(prhs[3]));
+    for(mwIndex i = 0; i < candidates.size(); i++) {
+        TuneConfig& cfg = candidates[i];
+        cfg.compression_level = get_tune_field(prhs[3], i, "compression_level");
+        cfg.blocksize = get_tune_field(prhs[3], i, "blocksize");
+        cfg.max_lpc_order = get_tune_field(prhs[3], i, "max_lpc_order");
+        cfg.qlp_coeff_precision = get_tune_field(prhs[3], i, "qlp_coeff_precision");
+        cfg.min_residual_partition_order = get_tune_field(prhs[3], i, "min_residual_partition_order");
+        cfg.max_residual_partition_order = get_tune_field(prhs[3], i, "max_residual_partition_order");
+
+        const mxArray* field = mxGetField(prhs[3], i, "apodization");
+        if(field && mxIsChar(field) && !mxIsEmpty(field)) {
+            char* str = mxArrayToString(field);
+            cfg.apodization = str;
+            mxFree(str);
+        }
+    }
+
+    unsigned n_threads = static_cast<unsigned>(mxGetScalar(prhs[5]));
+
+    // The actual work
+    std::vector<TuneResult> results(candidates.size());
+    std::vector<std::string> errors = parallel_for(candidates.size(), n_threads, [&](size_t i) {
+        results[i] = run_candidate(settings, candidates[i], slices);
+    });
+    for(size_t i = 0; i < errors.size(); i++) {
+        if(!errors[i].empty()) {
+            results[i].ok = false;
+            results[i].message = errors[i];
+        }
+    }
+
+    // Package it up as a struct
+    static const char* fieldnames[] = {"ok", "message", "bytes", "compression_ratio", "encode_rate", "decode_rate"};
+    const int n_fields = 6;
+    plhs[0] = mxCreateStructMatrix(1, candidates.size(), n_fields, fieldnames);
+
+    for(mwIndex i = 0; i < results.size(); i++) {
+        const TuneResult& r = results[i];
+        double raw_bytes = static_cast<double>(r.n_samples) * settings.channels * settings.bits_per_sample / 8.0;
+
+        mxSetFieldByNumber(plhs[0], i, 0, mxCreateLogicalScalar(r.ok));
+        mxSetFieldByNumber(plhs[0], i, 1, mxCreateString(r.message.c_str()));
+        mxSetFieldByNumber(plhs[0], i, 2, mxCreateDoubleScalar(static_cast<double>(r.bytes)));
+        mxSetFieldByNumber(plhs[0], i, 3, mxCreateDoubleScalar(r.ok ? raw_bytes / r.bytes : NAN));
+        mxSetFieldByNumber(plhs[0], i, 4, mxCreateDoubleScalar(r.ok ? r.n_samples / r.encode_seconds : NAN));
+        mxSetFieldByNumber(plhs[0], i, 5, mxCreateDoubleScalar(r.ok ? r.n_samples / r.decode_seconds : NAN));
+    }
+}
+
+
+static void get_metadata_spec(const mxArray* comments, const mxArray* applications, MetadataSpec& spec) {
+    /* Comments: cell array of 'NAME=value' strings
+     * Applications: struct array with fields id (4 characters) and data (uint8)
+     */
+    if(!mxIsEmpty(comments) && !mxIsCell(comments)) {
+        mexErrMsgIdAndTxt("FileEncoder:Metadata:ArgType", "Comments must be a cell array of 'NAME=value' strings");
+    }
+    for(mwIndex i = 0; i < mxGetNumberOfElements(comments); i++) {
+        const mxArray* cell = mxGetCell(comments, i);
+        char* str = cell ? mxArrayToUTF8String(cell) : NULL;
+        if(!str) {
+            mexErrMsgIdAndTxt("FileEncoder:Metadata:ArgType", "Comment #%d is not a string", static_cast<int>(i+1));
+        }
+        std::string comment(str);
+        mxFree(str);
+        
+        if(!FLAC::Metadata::VorbisComment::Entry(comment.c_str()).is_valid() || comment.find('=') == std::string::npos) {
+            mexErrMsgIdAndTxt("FileEncoder:Metadata:BadComment", "Comment '%s' is not of the form NAME=value", comment.c_str());
+        }
+        spec.comments.push_back(comment);
+    }
+    
+    if(!mxIsEmpty(applications) && !mxIsStruct(applications)) {
+        mexErrMsgIdAndTxt("FileEncoder:Metadata:ArgType", "Applications must be a struct array with fields id and data");
+    }
+    for(mwIndex i = 0; i < mxGetNumberOfElements(applications); i++) {
+        const mxArray* id = mxGetField(applications, i, "id");
+        const mxArray* data = mxGetField(applications, i, "data");
+        
+        char id_str[5];
+        if(!id || mxGetString(id, id_str, sizeof(id_str)) || strlen(id_str) != 4) {
+            mexErrMsgIdAndTxt("FileEncoder:Metadata:BadApplication", "Application #%d needs a four-character id", static_cast<int>(i+1));
+        }
+        if(data && !mxIsEmpty(data) && !mxIsUint8(data)) {
+            mexErrMsgIdAndTxt("FileEncoder:Metadata:BadApplication", "Data for application '%s' must be uint8", id_str);
+        }
+        
+        MetadataSpec::App app;
+        memcpy(app.id, id_str, 4);
+        if(data && !mxIsEmpty(data)) {
+            const FLAC__byte* bytes = static_cast<const FLAC__byte*>(mxGetData(data));
+            app.data.assign(bytes, bytes + mxGetNumberOfElements(data));
+        }
+        spec.applications.push_back(app);
+    }
+}
+
+static FLAC::Metadata::Application* make_application(const MetadataSpec::App& app) {
+    FLAC::Metadata::Application* block = new FLAC::Metadata::Application;
+    block->set_id(app.id);
+    if(!app.data.empty())
+        block->set_data(app.data.data(), static_cast<unsigned>(app.data.size()));
+    return block;
+}
+
+void set_metadata(int nlhs, int nrhs, const mxArray* prhs[], MetadataEncoder* encoder) {
+    /* Set the metadata written at the start of the file
+     *  Inputs: comments, applications (see get_metadata_spec), and
+     *          the size of the PADDING block (empty or negative for none)
+     */
+    if(nlhs > 0 || nrhs != 5) {
+        mexErrMsgIdAndTxt("FileEncoder:Internal:SetArgs", 
+                "set_metadata takes comments, applications and padding (plus obj/command inputs), but nlhs= %d and nrhs=%d.", nlhs, nrhs);
+    }
+    
+    MetadataSpec spec;
+    get_metadata_spec(prhs[2], prhs[3], spec);
+    spec.padding = mxIsEmpty(prhs[4]) ? -1 : static_cast<long>(mxGetScalar(prhs[4]));
+    
+    // Block order: tags, applications, then padding last so it can absorb later edits
+    std::vector<FLAC::Metadata::Prototype*> blocks;
+    if(!spec.comments.empty()) {
+        FLAC::Metadata::VorbisComment* tags = new FLAC::Metadata::VorbisComment;
+        for(auto& comment : spec.comments)
+            tags->append_comment(FLAC::Metadata::VorbisComment::Entry(comment.c_str()));
+        blocks.push_back(tags);
+    }
+    
+    for(auto& app : spec.applications)
+        blocks.push_back(make_application(app));
+    
+    if(spec.padding >= 0) {
+        FLAC::Metadata::Padding* padding = new FLAC::Metadata::Padding;
+        padding->set_length(static_cast<unsigned>(spec.padding));
+        blocks.push_back(padding);
+    }
+    
+    if(!encoder->set_metadata_blocks(blocks)) {
+        mexErrMsgIdAndTxt("FileEncoder:Interal:SetFailed", "Could not set metadata (has the encoder already been initialized?)");
+    }
+}
+
+void update_metadata(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]) {
+    /* Rewrite the tags/application blocks of an existing file in place.
+     *  Inputs: filename, comments, applications (see get_metadata_spec),
+     *          and whether the whole file may be rewritten if the 
+     *          new metadata doesn't fit in the existing padding
+     *  Output: true if the whole file had to be rewritten
+     *
+     * Comments replace any existing comments with the same NAME; other
+     * comments are kept. Applications replace blocks with the same id.
+     */
+    if(nlhs > 1 || nrhs != 5) {
+        mexErrMsgIdAndTxt("FileEncoder:Internal:UpdateMetadataArgs", 
+                "update_metadata takes a filename, comments, applications, and allow_rewrite, but nlhs= %d and nrhs=%d.", nlhs, nrhs);
+    }
+    
+    char* str = mxArrayToString(prhs[1]);
+    if(!str) {
+        mexErrMsgIdAndTxt("FileEncoder:FilenameNotString", "Filename is not a string or convertible to one.");
+    }
+    std::string filename(str);
+    mxFree(str);
+    
+    MetadataSpec spec;
+    get_metadata_spec(prhs[2], prhs[3], spec);
+    bool allow_rewrite = static_cast<bool>(mxGetScalar(prhs[4]));
+    
+    FLAC::Metadata::Chain chain;
+    if(!chain.is_valid() || !chain.read(filename.c_str())) {
+        mexErrMsgIdAndTxt("FileEncoder:Metadata:ReadError", "Unable to read metadata from %s: %s", 
+                filename.c_str(), chain.status().as_cstring());
+    }
+    
+    FLAC::Metadata::Iterator it;
+    it.init(chain);
+    bool found_tags = false;
+    std::vector<bool> replaced(spec.applications.size(), false);
+    do {
+        if(it.get_block_type() == FLAC__METADATA_TYPE_VORBIS_COMMENT && !spec.comments.empty() && !found_tags) {
+            FLAC::Metadata::Prototype* block = it.get_block(); // Refers to the chain's copy
+            FLAC::Metadata::VorbisComment* tags = dynamic_cast<FLAC::Metadata::VorbisComment*>(block);
+            if(tags) {
+                for(auto& comment : spec.comments) {
+                    std::string name = comment.substr(0, comment.find('='));
+                    tags->remove_entries_matching(name.c_str());
+                }
+                for(auto& comment : spec.comments)
+                    tags->append_comment(FLAC::Metadata::VorbisComment::Entry(comment.c_str()));
+                found_tags = true;
+            }
+            delete block;
+        } else if(it.get_block_type() == FLAC__METADATA_TYPE_APPLICATION) {
+            FLAC::Metadata::Prototype* block = it.get_block();
+            FLAC::Metadata::Application* app = dynamic_cast<FLAC::Metadata::Application*>(block);
+            for(size_t a = 0; app && a < spec.applications.size(); a++) {
+                if(!replaced[a] && !memcmp(app->get_id(), spec.applications[a].id, 4)) {
+                    FLAC::Metadata::Application* new_app = make_application(spec.applications[a]);
+                    if(!it.set_block(new_app)) // The chain takes ownership on success
+                        delete new_app;
+                    replaced[a] = true;
+                    break;
+                }
+            }
+            delete block;
+        }
+    } while(it.next());
+    
+    // Anything new goes right after STREAMINFO (which is always first)
+    it.init(chain);
+    if(!spec.comments.empty() && !found_tags) {
+        FLAC::Metadata::VorbisComment* tags = new FLAC::Metadata::VorbisComment;
+        for(auto& comment : spec.comments)
+            tags->append_comment(FLAC::Metadata::VorbisComment::Entry(comment.c_str()));
+        if(!it.insert_block_after(tags))
+            delete tags;
+    }
+    for(size_t a = 0; a < spec.applications.size(); a++) {
+        if(!replaced[a]) {
+            FLAC::Metadata::Application* new_app = make_application(spec.applications[a]);
+            if(!it.insert_block_after(new_app))
+                delete new_app;
+        }
+    }
+    
+    // Padding has to be at the end to absorb size changes 
+    chain.sort_padding();
+    bool rewrite = chain.check_if_tempfile_needed(true);
+    if(rewrite && !allow_rewrite) {
+        mexErrMsgIdAndTxt("FileEncoder:Metadata:NoRoom", 
+                "Not enough padding in %s to update its metadata in place, and allow_rewrite is false", filename.c_str());
+    }
+    
+    if(!chain.write(true, false)) {
+        mexErrMsgIdAndTxt("FileEncoder:Metadata:WriteError", "Unable to write metadata to %s: %s", 
+                filename.c_str(), chain.status().as_cstring());
+    }
+    
+    if(nlhs > 0)
+        plhs[0] = mxCreateLogicalScalar(rewrite);
+}
@@ -0,0 +1,66 @@
+#ifndef __PARALLEL_FOR_HPP__
+#define __PARALLEL_FOR_HPP__
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Run job(i) for every i in [0, n_jobs) on a small pool of worker threads.
+ * Jobs are handed out one at a time, so a few slow jobs (big files,
+ * expensive settings) don't hold up everything else.
+ *
+ * n_threads == 0 uses one thread per core.
+ *
+ * The MEX API is *not* thread-safe, so job must not call any mx/mex
+ * functions. Gather inputs from MATLAB before calling this and build the
+ * outputs afterwards.
+ *
+ * Exceptions thrown by a job are caught here. The return value holds one
+ * string per job: empty if it finished, or the exception's message if not.
+ */
+template<class Job> inline std::vector<std::string> parallel_for(size_t n_jobs, unsigned n_threads, Job job)
+{
+    std::vector<std::string> errors(n_jobs);
+    auto run = [&](size_t i) {
+        try {
+            job(i);
+        } catch (std::exception& e) {
+            errors[i] = e.what();
+            if (errors[i].empty())
+                errors[i] = "Unknown error";
+        } catch (...) {
+            errors[i] = "Unknown error";
+        }
+    };
+
+    if (n_threads == 0)
+        n_threads = std::thread::hardware_concurrency();
+    if (n_threads == 0)
+        n_threads = 1; // hardware_concurrency() is allowed to give up
+    n_threads = static_cast<unsigned>(std::min<size_t>(n_threads, n_jobs));
+
+    if (n_threads <= 1) {
+        for (size_t i = 0; i < n_jobs; i++)
+            run(i);
+        return errors;
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    workers.reserve(n_threads);
+    for (unsigned t = 0; t < n_threads; t++) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < n_jobs; i = next++)
+                run(i);
+        });
+    }
+
+    for (auto& w : workers)
+        w.join();
+    return errors;
+}
+
+#endif // __PARALLEL_FOR_HPP__
@@ -0,0 +1,30 @@
+function check_interface(mex_name)
+%% CHECK_INTERFACE Make sure a MEX file supports the newer commands
+% Binaries built before the metadata and batch commands were added don't
+% know about them, and the encoder silently ignores unknown set_ commands.
+% This asks the MEX file for its interface version and raises an error if
+% it is missing or too old, rather than letting those calls misbehave.
+persistent checked
+required = 2;
+
+if isempty(checked)
+    checked = {};
+end
+if any(strcmp(checked, mex_name))
+    return;
+end
+
+try
+    version = feval(mex_name, 'interface_version');
+catch
+    version = 1; % Predates the interface_version command
+end
+
+if version < required
+    error('matlibFLAC:StaleMex', ...
+        ['%s is out of date (interface version %d, but %d is needed). ' ...
+        'Rebuild it with build.m; the binaries in /precompiled may be too old.'], ...
+        which(mex_name), version, required);
+end
+checked{end+1} = mex_name;
+end